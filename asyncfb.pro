@@ -1,7 +1,7 @@
 TEMPLATE=app
 CONFIG += debug
 
-unix:LIBS  += -lfbclient
+unix:LIBS  += -lfbclient -ldl
 
 HEADERS += src/main.h   src/database.h   src/database_p.h   src/sqlview.h
 SOURCES += src/main.cpp src/database.cpp src/database_p.cpp src/sqlview.cpp
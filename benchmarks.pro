@@ -0,0 +1,19 @@
+# Benchmarks of the Qt layer, kept out of the demo application:
+#   qmake -o Makefile.benchmarks benchmarks.pro
+#   make -f Makefile.benchmarks
+#   ./asyncfb-benchmarks pool|notifier
+# The IBPP benchmarks are in src/private/ibpp/tests/benchmarks.cpp.
+TEMPLATE=app
+TARGET=asyncfb-benchmarks
+CONFIG += debug console
+
+unix:LIBS  += -lfbclient -ldl
+
+HEADERS += src/benchmarks.h   src/database.h   src/database_p.h
+SOURCES += src/benchmarks.cpp src/database.cpp src/database_p.cpp
+
+win32:DEFINES  += IBPP_WINDOWS
+win32:DEFINES  -= UNICODE
+unix:DEFINES  += IBPP_LINUX
+
+SOURCES += src/private/ibpp/core/all_in_one.cpp
@@ -0,0 +1,223 @@
+#include <QCoreApplication>
+#include <QSemaphore>
+#include <QThread>
+#include <QDateTime>
+#include <QDebug>
+
+#include "benchmarks.h"
+#include "database.h"
+#include "database_p.h"
+
+// Benchmarks, run by "asyncfb-benchmarks <name>" (see benchmarks.pro):
+// pool, notifier.
+// Those which need a server use the database named by
+// ASYNCFB_BENCHMARK_DATABASE (and _USER, _PASSWORD) and are skipped
+// if it is not set or can't be opened.
+
+QString benchmarkEnv(const char *name, const QString &defaultValue = QString())
+{
+   QString value = QString::fromLocal8Bit(qgetenv(name).constData());
+   return value.isEmpty() ? defaultValue : value;
+}
+
+bool openBenchmarkDatabase(TsSqlDatabase *&database)
+{
+   database = new TsSqlDatabase(
+      "",
+      benchmarkEnv("ASYNCFB_BENCHMARK_DATABASE"),
+      benchmarkEnv("ASYNCFB_BENCHMARK_USER", "sysdba"),
+      benchmarkEnv("ASYNCFB_BENCHMARK_PASSWORD", "masterkey"));
+   database->openWaiting();
+   return database->isOpen();
+}
+
+// One connection, which runs a short query over and over, once all
+// connections of the run are open
+class PoolBenchmarkClient: public QThread
+{
+   private:
+      QSemaphore &m_ready, &m_start;
+      int m_queries;
+   public:
+      bool ok;
+      PoolBenchmarkClient(QSemaphore &ready, QSemaphore &start, int queries):
+         m_ready(ready), m_start(start), m_queries(queries), ok(false) {}
+      void run()
+      {
+         TsSqlDatabase *database;
+         ok = openBenchmarkDatabase(database);
+         if (ok)
+         {
+            TsSqlTransaction transaction(*database, TsSqlTransaction::tmRead);
+            TsSqlStatement statement(*database, transaction);
+            transaction.startWaiting();
+            statement.prepareWaiting("select count(*) from rdb$relations");
+            m_ready.release();
+            m_start.acquire();
+            TsSqlRow row;
+            for(int i = 0; i < m_queries; ++i)
+            {
+               statement.executeWaiting();
+               while(statement.fetchRow(row))
+                  ;
+            }
+            transaction.commitWaiting();
+            database->closeWaiting();
+         } else
+         {
+            m_ready.release();
+            m_start.acquire();
+         }
+         delete database;
+      }
+};
+
+// Queries per second of connections sharing threads of the worker pool.
+// The pool never stops threads, so the thread counts only go up.
+int benchmarkPool()
+{
+   TsSqlDatabase *probe;
+   bool available = openBenchmarkDatabase(probe);
+   delete probe;
+   if (!available)
+   {
+      qDebug() << "pool: skipped, no server (set ASYNCFB_BENCHMARK_DATABASE)";
+      return 0;
+   }
+   const int queries = 200;
+   const int threadCounts[]     = {1, 2, 4, 8};
+   const int connectionCounts[] = {1, 4, 16, 64};
+   qDebug() << "pool: threads, connections, queries/s";
+   for(int t = 0; t < 4; ++t)
+   {
+      TsSqlDatabase::setWorkerThreads(threadCounts[t]);
+      for(int c = 0; c < 4; ++c)
+      {
+         QSemaphore ready, start;
+         QList<PoolBenchmarkClient*> clients;
+         for(int i = 0; i < connectionCounts[c]; ++i)
+         {
+            clients.append(new PoolBenchmarkClient(ready, start, queries));
+            clients.last()->start();
+         }
+         ready.acquire(clients.size());
+         QTime timer;
+         timer.start();
+         start.release(clients.size());
+         bool ok = true;
+         for(int i = 0; i < clients.size(); ++i)
+         {
+            clients[i]->wait();
+            ok = ok && clients[i]->ok;
+         }
+         int elapsed = qMax(timer.elapsed(), 1);
+         qDeleteAll(clients);
+         if (!ok)
+         {
+            qDebug() << "pool: a connection failed";
+            return 1;
+         }
+         qDebug() << "pool:" << threadCounts[t] << connectionCounts[c]
+            << qint64(connectionCounts[c]) * queries * 1000 / elapsed;
+      }
+   }
+   return 0;
+}
+
+NotifierBenchmarkReceiver::NotifierBenchmarkReceiver(int expected):
+   m_expected(expected),
+   m_received(0),
+   notifier(0)
+{
+}
+
+void NotifierBenchmarkReceiver::customEvent(QEvent *event)
+{
+   if (event->type() != TsSqlNotifier::eventType())
+      return QObject::customEvent(event);
+   while (TsSqlNotification *notification = notifier->take())
+   {
+      delete notification;
+      received();
+   }
+}
+
+void NotifierBenchmarkReceiver::received()
+{
+   if (++m_received == m_expected)
+      QCoreApplication::quit();
+}
+
+void NotifierBenchmarkEmitter::emitExecuted(QObject *receiver)
+{
+   connect(this, SIGNAL(executed()), receiver, SLOT(received()), Qt::QueuedConnection);
+   emit executed();
+}
+
+// Sends count notifications from another thread, like a database-worker
+class NotifierBenchmarkProducer: public QThread
+{
+   private:
+      NotifierBenchmarkReceiver &m_receiver;
+      int m_count;
+      bool m_notifier;
+   public:
+      NotifierBenchmarkProducer(NotifierBenchmarkReceiver &receiver, int count, bool notifier):
+         m_receiver(receiver), m_count(count), m_notifier(notifier) {}
+      void run()
+      {
+         for(int i = 0; i < m_count; ++i)
+            if (m_notifier)
+               m_receiver.notifier->emitStatementExecuted();
+            else
+            {
+               NotifierBenchmarkEmitter emitter;
+               emitter.emitExecuted(&m_receiver);
+            }
+      }
+};
+
+// Notifications per second from a worker thread to an object on the main
+// thread, the former emitter against TsSqlNotifier. Needs no server.
+int benchmarkNotifier()
+{
+   const int count = 200000;
+   qDebug() << "notifier: method, notifications/s";
+   for(int notifier = 0; notifier < 2; ++notifier)
+   {
+      NotifierBenchmarkReceiver receiver(count);
+      TsSqlNotifier channel(&receiver);
+      receiver.notifier = &channel;
+      NotifierBenchmarkProducer producer(receiver, count, notifier);
+      QTime timer;
+      timer.start();
+      producer.start();
+      QCoreApplication::exec();
+      int elapsed = qMax(timer.elapsed(), 1);
+      producer.wait();
+      qDebug() << "notifier:" << (notifier ? "TsSqlNotifier" : "emitter per notification")
+         << qint64(count) * 1000 / elapsed;
+   }
+   return 0;
+}
+
+int runBenchmark(const QString &name)
+{
+   if (name == "pool")
+      return benchmarkPool();
+   if (name == "notifier")
+      return benchmarkNotifier();
+   qDebug() << "Unknown benchmark" << name;
+   return 1;
+}
+
+int main(int argc, char *argv[])
+{
+   QCoreApplication app(argc, argv);
+   if (argc < 2)
+   {
+      qDebug() << "Usage: asyncfb-benchmarks pool|notifier";
+      return 1;
+   }
+   return runBenchmark(argv[1]);
+}
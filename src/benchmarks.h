@@ -0,0 +1,35 @@
+#ifndef TS_BENCHMARKS_H_16102026
+#define TS_BENCHMARKS_H_16102026
+
+#include <QObject>
+#include <QEvent>
+
+// The receiving end of the notifier benchmark, counts the notifications
+// taken from notifier (see TsSqlNotifier) or the signals of the former
+// per-notification emitter. Quits the event loop once all arrived.
+class NotifierBenchmarkReceiver: public QObject
+{
+   Q_OBJECT
+   private:
+      int m_expected, m_received;
+   protected:
+      virtual void customEvent(QEvent *event);
+   public:
+      class TsSqlNotifier *notifier;
+      NotifierBenchmarkReceiver(int expected);
+   public slots:
+      void received();
+};
+
+// Emits a notification the way it was done before TsSqlNotifier: with a
+// QObject and a connect() for each one.
+class NotifierBenchmarkEmitter: public QObject
+{
+   Q_OBJECT
+   public:
+      void emitExecuted(QObject *receiver);
+   signals:
+      void executed();
+};
+
+#endif
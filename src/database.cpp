@@ -3,53 +3,142 @@
 
 #include <QThread>
 
+#include <new>
+
+namespace
+{
+   // The shared values must fit into TsSqlVariantData::asShared
+   typedef char TsSqlSharedSizeCheck[
+      sizeof(QString) <= sizeof(void*) && 
+      sizeof(QByteArray) <= sizeof(void*) && 
+      sizeof(QVector<double>) <= sizeof(void*) ? 1 : -1];
+
+   // Julian day of 17.11.1858, day 0 of Firebird's dates
+   const int julianDayOffset = 2400001;
+
+   int encodeDate(const QDate &date)
+   {
+      return date.toJulianDay() - julianDayOffset;
+   }
+
+   unsigned encodeTime(const QTime &time)
+   {
+      return QTime(0, 0).msecsTo(time) * 10;
+   }
+
+   QDate decodeDate(int date)
+   {
+      return QDate::fromJulianDay(date + julianDayOffset);
+   }
+
+   QTime decodeTime(unsigned time)
+   {
+      return QTime(0, 0).addMSecs(time / 10);
+   }
+}
+
 TsSqlVariant::TsSqlVariant(): 
-   m_type(stUnknown),
-   m_delete(false)
+   m_type(stUnknown)
 {
-   m_data.asPointer = 0;
+   m_data.asInt64 = 0;
 }
 
 TsSqlVariant::TsSqlVariant(const TsSqlVariant &copy):
-   m_type(copy.m_type)
+   m_type(stUnknown)
 {
-   switch(m_type)
+   copyValue(copy);
+}
+
+#ifdef Q_COMPILER_RVALUE_REFS
+TsSqlVariant::TsSqlVariant(TsSqlVariant &&other):
+   m_type(stUnknown)
+{
+   m_data.asInt64 = 0;
+   swap(other);
+}
+
+TsSqlVariant &TsSqlVariant::operator=(TsSqlVariant &&other)
+{
+   swap(other);
+   return *this;
+}
+#endif
+
+TsSqlVariant::~TsSqlVariant()
+{
+   setNull();
+}
+
+TsSqlVariant &TsSqlVariant::operator=(const TsSqlVariant &copy)
+{
+   if (this != &copy)
+   {
+      setNull();
+      copyValue(copy);
+   }
+   return *this;
+}
+
+void TsSqlVariant::swap(TsSqlVariant &other)
+{
+   // QString and QByteArray only hold a pointer to their shared data,
+   // so their bits can be swapped like any other value.
+   TsSqlVariantData data = m_data;
+   m_data = other.m_data;
+   other.m_data = data;
+   TsSqlType type = m_type;
+   m_type = other.m_type;
+   other.m_type = type;
+}
+
+void TsSqlVariant::copyValue(const TsSqlVariant &copy)
+{
+   switch(copy.m_type)
    {
       case stBlob:
-         m_data.asPointer =
-            new QByteArray(*reinterpret_cast<QByteArray*>(copy.m_data.asPointer));
-         m_delete = true;
-         break;
-      case stDate:
-         m_data.asPointer =
-            new QDate(*reinterpret_cast<QDate*>(copy.m_data.asPointer));
-         m_delete = true;
-         break;
-      case stTime:
-         m_data.asPointer =
-            new QTime(*reinterpret_cast<QTime*>(copy.m_data.asPointer));
-         m_delete = true;
-         break;
-      case stTimeStamp:
-         m_data.asPointer =
-            new QDateTime(*reinterpret_cast<QDateTime*>(copy.m_data.asPointer));
-         m_delete = true;
+         new (m_data.asShared) QByteArray(copy.sharedData());
          break;
       case stString:
-         m_data.asPointer =
-            new QString(*reinterpret_cast<QString*>(copy.m_data.asPointer));
-         m_delete = true;
+         new (m_data.asShared) QString(copy.sharedString());
+         break;
+      case stArray:
+         new (m_data.asShared) QVector<double>(copy.sharedArray());
          break;
       default:
-         m_data.asDouble = copy.m_data.asDouble; // Copy the biggest union-member
-         m_delete = false;
+         m_data = copy.m_data;
          break;
    }
+   m_type = copy.m_type;
 }
 
-TsSqlVariant::~TsSqlVariant()
+QString &TsSqlVariant::sharedString()
 {
-   setNull();
+   return *reinterpret_cast<QString*>(m_data.asShared);
+}
+
+const QString &TsSqlVariant::sharedString() const
+{
+   return *reinterpret_cast<const QString*>(m_data.asShared);
+}
+
+QByteArray &TsSqlVariant::sharedData()
+{
+   return *reinterpret_cast<QByteArray*>(m_data.asShared);
+}
+
+const QByteArray &TsSqlVariant::sharedData() const
+{
+   return *reinterpret_cast<const QByteArray*>(m_data.asShared);
+}
+
+QVector<double> &TsSqlVariant::sharedArray()
+{
+   return *reinterpret_cast<QVector<double>*>(m_data.asShared);
+}
+
+const QVector<double> &TsSqlVariant::sharedArray() const
+{
+   return *reinterpret_cast<const QVector<double>*>(m_data.asShared);
 }
 
 TsSqlType TsSqlVariant::type() const
@@ -59,57 +148,48 @@ TsSqlType TsSqlVariant::type() const
 
 bool TsSqlVariant::isNull() const
 {
-   return m_type == stUnknown && m_data.asPointer == 0;
+   return m_type == stUnknown;
 }
 
 void TsSqlVariant::setNull()
 {
-   if (m_delete)
+   switch(m_type)
    {
-      switch(m_type)
-      {
-         case stBlob:
-            delete reinterpret_cast<QByteArray*>(m_data.asPointer);
-            break;
-         case stDate:
-            delete reinterpret_cast<QDate*>(m_data.asPointer);
-            break;
-         case stTime:
-            delete reinterpret_cast<QTime*>(m_data.asPointer);
-            break;
-         case stTimeStamp:
-            delete reinterpret_cast<QDateTime*>(m_data.asPointer);
-            break;
-         case stString:
-            delete reinterpret_cast<QString*>(m_data.asPointer);
-            break;
-         default:
-            break;
-      }
+      case stBlob:
+         sharedData().~QByteArray();
+         break;
+      case stString:
+         sharedString().~QString();
+         break;
+      case stArray:
+         sharedArray().~QVector<double>();
+         break;
+      default:
+         break;
    }
-   m_data.asPointer = 0;
+   m_data.asInt64 = 0;
    m_type = stUnknown;
-   m_delete = false;
 }
 
 void TsSqlVariant::setVariant(const QVariant &value)
 {
+   // If a value is set already, the new value is converted to it's type
    switch(m_type)
    {
       case stBlob:
-         *reinterpret_cast<QByteArray*>(m_data.asPointer) = value.toByteArray();
+         set(value.toByteArray());
          break;
       case stDate:
-         *reinterpret_cast<QDate*>(m_data.asPointer) = value.toDate();
+         set(value.toDate());
          break;
       case stTime:
-         *reinterpret_cast<QTime*>(m_data.asPointer) = value.toTime();
+         set(value.toTime());
          break;
       case stTimeStamp:
-         *reinterpret_cast<QDateTime*>(m_data.asPointer) = value.toDateTime();
+         set(value.toDateTime());
          break;
       case stString:
-         *reinterpret_cast<QString*>(m_data.asPointer) = value.toString();
+         set(value.toString());
          break;
       case stSmallInt:
          m_data.asInt16 = value.toInt();
@@ -128,54 +208,125 @@ void TsSqlVariant::setVariant(const QVariant &value)
          break;
       default:
          // If none or an incompatible type is currently set
-         setNull();
          switch(value.type())
          {
+            case QVariant::Invalid:
+               setNull();
+               break;
             case QVariant::ByteArray:
-               newValue(value.toByteArray(), stBlob);
+               set(value.toByteArray());
                break;
             case QVariant::Date:
-               newValue(value.toDate(), stDate);
+               set(value.toDate());
                break;
             case QVariant::DateTime:
-               newValue(value.toDateTime(), stTimeStamp);
+               set(value.toDateTime());
                break;
             case QVariant::Double:
-               m_data.asDouble = value.toDouble();
-               m_type = stDouble;
-               m_delete = false;
+               set(value.toDouble());
                break;
             case QVariant::Int:
-               m_data.asInt32 = value.toInt();
-               m_type = stInt;
-               m_delete = false;
+               set(static_cast<TsSqlInt>(value.toInt()));
                break;
             case QVariant::LongLong:
-               m_data.asInt64 = value.toLongLong();
-               m_type = stLargeInt;
-               m_delete = false;
+               set(static_cast<TsSqlLargeInt>(value.toLongLong()));
                break;
             case QVariant::Time:
-               newValue(value.toTime(), stTime);
+               set(value.toTime());
                break;
             case QVariant::UInt:
-               m_data.asInt32 = value.toUInt();
-               m_type = stInt;
-               m_delete = false;
+               set(static_cast<TsSqlInt>(value.toUInt()));
                break;
             case QVariant::ULongLong:
-               m_data.asInt64 = value.toULongLong();
-               m_type = stLargeInt;
-               m_delete = false;
+               set(static_cast<TsSqlLargeInt>(value.toULongLong()));
                break;
             default:
                // Save it as string, if nothing else matched
-               newValue(value.toString(), stString);
+               set(value.toString());
                break;
          }
    }
 }
 
+void TsSqlVariant::set(const QString &value)
+{
+   if (m_type == stString)
+      sharedString() = value;
+   else
+   {
+      setNull();
+      new (m_data.asShared) QString(value);
+      m_type = stString;
+   }
+}
+
+void TsSqlVariant::set(const QByteArray &value)
+{
+   if (m_type == stBlob)
+      sharedData() = value;
+   else
+   {
+      setNull();
+      new (m_data.asShared) QByteArray(value);
+      m_type = stBlob;
+   }
+}
+
+void TsSqlVariant::setDateTime(TsSqlType type, int date, unsigned time)
+{
+   setNull();
+   m_data.asTimeStamp.date = date;
+   m_data.asTimeStamp.time = time;
+   m_type = type;
+}
+
+// Invalid dates and times have no representation in the database,
+// so they are stored as NULL.
+void TsSqlVariant::set(const QDate &value)
+{
+   if (value.isValid())
+      setDateTime(stDate, encodeDate(value), 0);
+   else
+      setNull();
+}
+
+void TsSqlVariant::set(const QTime &value)
+{
+   if (value.isValid())
+      setDateTime(stTime, 0, encodeTime(value));
+   else
+      setNull();
+}
+
+void TsSqlVariant::set(const QDateTime &value)
+{
+   if (value.isValid())
+      setDateTime(stTimeStamp, encodeDate(value.date()), encodeTime(value.time()));
+   else
+      setNull();
+}
+
+void TsSqlVariant::set(TsSqlSmallInt value)
+{
+   setNull();
+   m_data.asInt16 = value;
+   m_type = stSmallInt;
+}
+
+void TsSqlVariant::set(TsSqlInt value)
+{
+   setNull();
+   m_data.asInt32 = value;
+   m_type = stInt;
+}
+
+void TsSqlVariant::set(TsSqlLargeInt value)
+{
+   setNull();
+   m_data.asInt64 = value;
+   m_type = stLargeInt;
+}
+
 void TsSqlVariant::set(float value)
 {
    setNull();
@@ -183,20 +334,46 @@ void TsSqlVariant::set(float value)
    m_type = stFloat;
 }
 
+void TsSqlVariant::set(double value)
+{
+   setNull();
+   m_data.asDouble = value;
+   m_type = stDouble;
+}
+
+void TsSqlVariant::set(const TsSqlBlobId &value)
+{
+   setNull();
+   m_data.asBlobId = value;
+   m_type = stBlobId;
+}
+
+void TsSqlVariant::set(const QVector<double> &value)
+{
+   if (m_type == stArray)
+      sharedArray() = value;
+   else
+   {
+      setNull();
+      new (m_data.asShared) QVector<double>(value);
+      m_type = stArray;
+   }
+}
+
 QVariant TsSqlVariant::asVariant() const
 {
    switch(m_type)
    {
       case stBlob:
-         return QVariant(*reinterpret_cast<QByteArray*>(m_data.asPointer));
+         return QVariant(sharedData());
       case stDate:
-         return QVariant(*reinterpret_cast<QDate*>(m_data.asPointer));
+         return QVariant(asDate());
       case stTime:
-         return QVariant(*reinterpret_cast<QTime*>(m_data.asPointer));
+         return QVariant(asTime());
       case stTimeStamp:
-         return QVariant(*reinterpret_cast<QDateTime*>(m_data.asPointer));
+         return QVariant(asTimeStamp());
       case stString:
-         return QVariant(*reinterpret_cast<QString*>(m_data.asPointer));
+         return QVariant(sharedString());
       case stSmallInt:
          return QVariant(m_data.asInt16);
       case stInt:
@@ -207,6 +384,16 @@ QVariant TsSqlVariant::asVariant() const
          return QVariant(m_data.asFloat);
       case stDouble:
          return QVariant(m_data.asDouble);
+      case stBlobId:
+         return QVariant::fromValue(m_data.asBlobId);
+      case stArray:
+         {
+            QVariantList result;
+            const QVector<double> &values = sharedArray();
+            for(int i = 0; i < values.size(); ++i)
+               result.append(values[i]);
+            return QVariant(result);
+         }
       default:
          return QVariant();
    }
@@ -214,54 +401,274 @@ QVariant TsSqlVariant::asVariant() const
 
 QByteArray TsSqlVariant::asData() const
 {
+   if (m_type == stBlob)
+      return sharedData();
    return asVariant().toByteArray();
 }
 
 QString TsSqlVariant::asString() const
 {
+   if (m_type == stString)
+      return sharedString();
    return asVariant().toString();
 }
 
 TsSqlSmallInt TsSqlVariant::asInt16() const
 {
-   return asVariant().toInt();
+   return asInt64();
 }
 
 TsSqlInt TsSqlVariant::asInt32() const
 {
-   return asVariant().toInt();
+   return asInt64();
 }
 
 TsSqlLargeInt TsSqlVariant::asInt64() const
 {
-   return asVariant().toInt();
+   switch(m_type)
+   {
+      case stSmallInt:
+         return m_data.asInt16;
+      case stInt:
+         return m_data.asInt32;
+      case stLargeInt:
+         return m_data.asInt64;
+      case stFloat:
+         return static_cast<TsSqlLargeInt>(m_data.asFloat);
+      case stDouble:
+         return static_cast<TsSqlLargeInt>(m_data.asDouble);
+      default:
+         return asVariant().toLongLong();
+   }
 }
 
 float TsSqlVariant::asFloat() const
 {
-   return asVariant().toDouble();
+   return asDouble();
 }
 
 double TsSqlVariant::asDouble() const
 {
-   return asVariant().toDouble();
+   switch(m_type)
+   {
+      case stSmallInt:
+         return m_data.asInt16;
+      case stInt:
+         return m_data.asInt32;
+      case stLargeInt:
+         return static_cast<double>(m_data.asInt64);
+      case stFloat:
+         return m_data.asFloat;
+      case stDouble:
+         return m_data.asDouble;
+      default:
+         return asVariant().toDouble();
+   }
 }
 
 QDateTime TsSqlVariant::asTimeStamp() const
 {
-   return asVariant().toDateTime();
+   switch(m_type)
+   {
+      case stTimeStamp:
+         return QDateTime(
+            decodeDate(m_data.asTimeStamp.date),
+            decodeTime(m_data.asTimeStamp.time));
+      case stDate:
+         return QDateTime(decodeDate(m_data.asTimeStamp.date));
+      default:
+         return asVariant().toDateTime();
+   }
 }
 
 QDate TsSqlVariant::asDate() const
 {
+   if (m_type == stDate || m_type == stTimeStamp)
+      return decodeDate(m_data.asTimeStamp.date);
    return asVariant().toDate();
 }
 
 QTime TsSqlVariant::asTime() const
 {
+   if (m_type == stTime || m_type == stTimeStamp)
+      return decodeTime(m_data.asTimeStamp.time);
    return asVariant().toTime();
 }
 
+TsSqlBlobId TsSqlVariant::asBlobId() const
+{
+   if (m_type == stBlobId)
+      return m_data.asBlobId;
+   TsSqlBlobId result = {0, 0};
+   return result;
+}
+
+QVector<double> TsSqlVariant::asArray() const
+{
+   if (m_type == stArray)
+      return sharedArray();
+   return QVector<double>();
+}
+
+TsSqlColumnarBuffer::TsSqlColumnarBuffer():
+   m_impl(new TsSqlColumnarBufferImpl())
+{
+}
+
+TsSqlColumnarBuffer::~TsSqlColumnarBuffer()
+{
+   delete m_impl;
+}
+
+void TsSqlColumnarBuffer::clear()
+{
+   m_impl->clear();
+}
+
+int TsSqlColumnarBuffer::rowCount() const
+{
+   return m_impl->m_rowCount;
+}
+
+int TsSqlColumnarBuffer::columnCount() const
+{
+   return m_impl->m_columns.size();
+}
+
+QString TsSqlColumnarBuffer::columnName(int column) const
+{
+   return m_impl->m_columns[column].name;
+}
+
+TsSqlType TsSqlColumnarBuffer::columnType(int column) const
+{
+   return m_impl->m_columns[column].type;
+}
+
+bool TsSqlColumnarBuffer::isNull(int row, int column) const
+{
+   return m_impl->m_columns[column].nulls[row / 32] & (1u << (row % 32));
+}
+
+const quint32 *TsSqlColumnarBuffer::nullBitmap(int column) const
+{
+   return m_impl->m_columns[column].nulls.constData();
+}
+
+const TsSqlSmallInt *TsSqlColumnarBuffer::int16Column(int column) const
+{
+   return m_impl->typedColumn<TsSqlSmallInt>(column, stSmallInt);
+}
+
+const TsSqlInt *TsSqlColumnarBuffer::int32Column(int column) const
+{
+   return m_impl->typedColumn<TsSqlInt>(column, stInt);
+}
+
+const TsSqlLargeInt *TsSqlColumnarBuffer::int64Column(int column) const
+{
+   return m_impl->typedColumn<TsSqlLargeInt>(column, stLargeInt);
+}
+
+const float *TsSqlColumnarBuffer::floatColumn(int column) const
+{
+   return m_impl->typedColumn<float>(column, stFloat);
+}
+
+const double *TsSqlColumnarBuffer::doubleColumn(int column) const
+{
+   return m_impl->typedColumn<double>(column, stDouble);
+}
+
+const TsSqlTimeStampData *TsSqlColumnarBuffer::timeStampColumn(int column) const
+{
+   switch(m_impl->m_columns[column].type)
+   {
+      case stDate:
+      case stTime:
+      case stTimeStamp:
+         return reinterpret_cast<const TsSqlTimeStampData*>(
+            m_impl->m_columns[column].values.constData());
+      default:
+         return 0;
+   }
+}
+
+const char *TsSqlColumnarBuffer::stringData(int column) const
+{
+   if (m_impl->m_columns[column].offsets.isEmpty())
+      return 0;
+   return m_impl->m_columns[column].values.constData();
+}
+
+const int *TsSqlColumnarBuffer::stringOffsets(int column) const
+{
+   if (m_impl->m_columns[column].offsets.isEmpty())
+      return 0;
+   return m_impl->m_columns[column].offsets.constData();
+}
+
+TsSqlVariant TsSqlColumnarBuffer::value(int row, int column) const
+{
+   TsSqlVariant result;
+   if (isNull(row, column))
+      return result;
+   const TsSqlColumnData &data = m_impl->m_columns[column];
+   switch(data.type)
+   {
+      case stSmallInt:
+         result.set(int16Column(column)[row]);
+         break;
+      case stInt:
+         result.set(int32Column(column)[row]);
+         break;
+      case stLargeInt:
+         result.set(int64Column(column)[row]);
+         break;
+      case stFloat:
+         result.set(floatColumn(column)[row]);
+         break;
+      case stDouble:
+         result.set(doubleColumn(column)[row]);
+         break;
+      case stDate:
+      case stTime:
+      case stTimeStamp:
+         {
+            const TsSqlTimeStampData &ts = timeStampColumn(column)[row];
+            result.setDateTime(data.type, ts.date, ts.time);
+            break;
+         }
+      case stString:
+         {
+            const int *offsets = data.offsets.constData();
+            result.set(QString::fromAscii(
+               data.values.constData() + offsets[row],
+               offsets[row + 1] - offsets[row]));
+            break;
+         }
+      case stBlob:
+         {
+            const int *offsets = data.offsets.constData();
+            result.set(QByteArray(
+               data.values.constData() + offsets[row],
+               offsets[row + 1] - offsets[row]));
+            break;
+         }
+      default:
+         break;
+   }
+   return result;
+}
+
+TsSqlRow TsSqlColumnarBuffer::row(int row) const
+{
+   TsSqlRow result(columnCount());
+   for(int i = 0; i < result.size(); ++i)
+      result[i] = value(row, i);
+   return result;
+}
+
 TsSqlBuffer::TsSqlBuffer():
    m_impl(new TsSqlBufferImpl())
 {
@@ -287,13 +694,48 @@ void TsSqlBuffer::setStatements(TsSqlStatement *dataStatement, TsSqlStatement *f
    m_impl->setStatements(dataStatement, fetchStatement);
 }
 
+TsSqlVariant TsSqlBuffer::cell(unsigned row, unsigned column)
+{
+   return m_impl->cell(row, column);
+}
+
+TsSqlVariant TsSqlBuffer::value(unsigned row, unsigned column)
+{
+   return m_impl->cell(row, column);
+}
+
+void TsSqlBuffer::withRow(unsigned row, TsSqlRowVisitor visitor, void *context)
+{
+   m_impl->withRow(row, visitor, context);
+}
+
+void TsSqlBuffer::setLazyBlobs(bool lazy, int cacheSize)
+{
+   m_impl->setLazyBlobs(lazy, cacheSize);
+}
+
+bool TsSqlBuffer::lazyBlobs() const
+{
+   return m_impl->lazyBlobs();
+}
+
 void TsSqlBuffer::connectSignals()
 {
    connect(m_impl, SIGNAL(cleared()),            this, SIGNAL(cleared()));
    connect(m_impl, SIGNAL(rowAppended()),        this, SIGNAL(rowAppended()));
-   connect(m_impl, SIGNAL(rowDeleted()),         this, SIGNAL(rowDeleted()));
+   connect(m_impl, SIGNAL(rowDeleted(unsigned)), this, SIGNAL(rowDeleted(unsigned)));
    connect(m_impl, SIGNAL(columnsChanged()),     this, SIGNAL(columnsChanged()));
    connect(m_impl, SIGNAL(rowFetched(TsSqlRow)), this, SIGNAL(rowFetched(TsSqlRow)));
+   connect(
+      m_impl,
+      SIGNAL(rowsResolved(unsigned, unsigned)),
+      this,
+      SIGNAL(rowsResolved(unsigned, unsigned)));
+   connect(
+      m_impl,
+      SIGNAL(rowsAppended(unsigned, unsigned)),
+      this,
+      SIGNAL(rowsAppended(unsigned, unsigned)));
 }
 
 TsSqlBuffer::~TsSqlBuffer()
@@ -351,6 +793,49 @@ TsSqlStatement *TsSqlBuffer::fetchStatement()
    return m_impl->fetchStatement();
 }
 
+void TsSqlBuffer::setBatchStatement(
+   TsSqlStatement *batchStatement,
+   int batchSize,
+   TsSqlStatement *prefetchStatement)
+{
+   m_impl->setBatchStatement(batchStatement, batchSize, prefetchStatement);
+}
+
+TsSqlStatement *TsSqlBuffer::batchStatement()
+{
+   return m_impl->batchStatement();
+}
+
+TsSqlStatement *TsSqlBuffer::prefetchStatement()
+{
+   return m_impl->prefetchStatement();
+}
+
+int TsSqlBuffer::batchSize() const
+{
+   return m_impl->batchSize();
+}
+
+void TsSqlBuffer::setViewport(unsigned first, unsigned last)
+{
+   m_impl->setViewport(first, last);
+}
+
+void TsSqlBuffer::setPrefetchMargin(unsigned rows)
+{
+   m_impl->setPrefetchMargin(rows);
+}
+
+unsigned TsSqlBuffer::prefetchMargin() const
+{
+   return m_impl->prefetchMargin();
+}
+
+bool TsSqlBuffer::isResolved(unsigned row) const
+{
+   return m_impl->isResolved(row);
+}
+
 /* The rest of this source-file only includes pimpl-forwards */
 
 TsSqlDatabase::TsSqlDatabase(
@@ -366,12 +851,13 @@ TsSqlDatabase::TsSqlDatabase(
             database,
             user,
             password,
-            role,
             characterSet,
+            role,
             createParams))
 {
    connect(m_impl, SIGNAL(opened()),       this, SIGNAL(opened()));
    connect(m_impl, SIGNAL(closed()),       this, SIGNAL(closed()));
+   connect(m_impl, SIGNAL(cancelled()),    this, SIGNAL(cancelled()));
    connect(m_impl, SIGNAL(error(QString)), this, SIGNAL(error(QString)));
 }
 
@@ -380,6 +866,16 @@ TsSqlDatabase::~TsSqlDatabase()
    delete m_impl;
 }
 
+void TsSqlDatabase::setWorkerThreads(int count)
+{
+   TsSqlWorkerPool::instance()->setMaximumThreads(count);
+}
+
+int TsSqlDatabase::workerThreads()
+{
+   return TsSqlWorkerPool::instance()->maximumThreads();
+}
+
 void TsSqlDatabase::test()
 {
    m_impl->test();
@@ -410,6 +906,36 @@ bool TsSqlDatabase::isOpen()
    return m_impl->isOpen();
 }
 
+bool TsSqlDatabase::ping()
+{
+   return m_impl->ping();
+}
+
+bool TsSqlDatabase::cancel()
+{
+   return m_impl->cancel();
+}
+
+void TsSqlDatabase::setStatementCacheSize(int size)
+{
+   m_impl->setStatementCacheSize(size);
+}
+
+int TsSqlDatabase::statementCacheSize()
+{
+   return m_impl->statementCacheSize();
+}
+
+int TsSqlDatabase::statementCacheHits()
+{
+   return m_impl->statementCacheHits();
+}
+
+int TsSqlDatabase::statementCacheMisses()
+{
+   return m_impl->statementCacheMisses();
+}
+
 QString TsSqlDatabase::server()
 {
    return m_impl->server();
@@ -450,6 +976,131 @@ QVector<QString> TsSqlDatabase::connectedUsers()
    return m_impl->connectedUsers();
 }
 
+TsSqlConnectionPool::TsSqlConnectionPool(
+   int minimumSize,
+   int maximumSize,
+   int idleTimeout,
+   int validationInterval):
+   m_impl(new TsSqlConnectionPoolImpl(
+            minimumSize,
+            maximumSize,
+            idleTimeout,
+            validationInterval))
+{
+}
+
+TsSqlConnectionPool::~TsSqlConnectionPool()
+{
+   delete m_impl;
+}
+
+void TsSqlConnectionPool::setMinimumSize(int size)
+{
+   m_impl->setMinimumSize(size);
+}
+
+void TsSqlConnectionPool::setMaximumSize(int size)
+{
+   m_impl->setMaximumSize(size);
+}
+
+void TsSqlConnectionPool::setIdleTimeout(int msecs)
+{
+   m_impl->setIdleTimeout(msecs);
+}
+
+void TsSqlConnectionPool::setValidationInterval(int msecs)
+{
+   m_impl->setValidationInterval(msecs);
+}
+
+int TsSqlConnectionPool::minimumSize()
+{
+   return m_impl->minimumSize();
+}
+
+int TsSqlConnectionPool::maximumSize()
+{
+   return m_impl->maximumSize();
+}
+
+int TsSqlConnectionPool::idleTimeout()
+{
+   return m_impl->idleTimeout();
+}
+
+int TsSqlConnectionPool::validationInterval()
+{
+   return m_impl->validationInterval();
+}
+
+TsSqlDatabase *TsSqlConnectionPool::acquire(
+   const QString &server,
+   const QString &database,
+   const QString &user,
+   const QString &password,
+   const QString &characterSet,
+   const QString &role,
+   int timeout)
+{
+   return m_impl->acquire(
+      server,
+      database,
+      user,
+      password,
+      characterSet,
+      role,
+      timeout);
+}
+
+void TsSqlConnectionPool::release(TsSqlDatabase *database)
+{
+   m_impl->release(database);
+}
+
+void TsSqlConnectionPool::expire()
+{
+   m_impl->expire();
+}
+
+TsSqlConnectionPool::Statistics TsSqlConnectionPool::statistics()
+{
+   return m_impl->statistics();
+}
+
+TsSqlConnectionLease::TsSqlConnectionLease(
+   TsSqlConnectionPool &pool,
+   const QString &server,
+   const QString &database,
+   const QString &user,
+   const QString &password,
+   const QString &characterSet,
+   const QString &role,
+   int timeout):
+   m_pool(pool),
+   m_database(pool.acquire(
+            server,
+            database,
+            user,
+            password,
+            characterSet,
+            role,
+            timeout))
+{
+}
+
+TsSqlConnectionLease::~TsSqlConnectionLease()
+{
+   release();
+}
+
+void TsSqlConnectionLease::release()
+{
+   if (m_database)
+      m_pool.release(m_database);
+   m_database = 0;
+}
+
 TsSqlTransaction::TsSqlTransaction(
    TsSqlDatabase &database, 
    TransactionMode mode):
@@ -542,9 +1193,16 @@ void TsSqlStatement::connectSignals()
 {
    connect(m_impl, SIGNAL(prepared()),        this, SIGNAL(prepared()));
    connect(m_impl, SIGNAL(executed()),        this, SIGNAL(executed()));
+   connect(
+      m_impl, 
+      SIGNAL(batchExecuted(int, TsSqlBatchErrors)), 
+      this, 
+      SIGNAL(batchExecuted(int, TsSqlBatchErrors)));
    connect(m_impl, SIGNAL(fetchStarted()),    this, SIGNAL(fetchStarted()));
    connect(m_impl, SIGNAL(fetched(TsSqlRow)), this, SIGNAL(fetched(TsSqlRow)));
+   connect(m_impl, SIGNAL(fetchedBatch(TsSqlRowBatch)), this, SIGNAL(fetchedBatch(TsSqlRowBatch)));
    connect(m_impl, SIGNAL(fetchFinished()),   this, SIGNAL(fetchFinished()));
+   connect(m_impl, SIGNAL(cancelled()),       this, SIGNAL(cancelled()));
    connect(m_impl, SIGNAL(error(QString)),    this, SIGNAL(error(QString)));
 }
 
@@ -608,6 +1266,32 @@ void TsSqlStatement::executeWaiting(
    m_impl->executeWaiting(sql, params);
 }
 
+void TsSqlStatement::executeBatch(const TsSqlRowBatch &params)
+{
+   m_impl->executeBatch(params);
+}
+
+int TsSqlStatement::executeBatchWaiting(
+   const TsSqlRowBatch &params,
+   TsSqlBatchErrors *errors)
+{
+   return m_impl->executeBatchWaiting(params, errors);
+}
+
+void TsSqlStatement::bindParam(
+   int column, 
+   TsSqlType type, 
+   const void *value, 
+   const bool *isNull)
+{
+   m_impl->bindParam(column, type, value, isNull);
+}
+
+void TsSqlStatement::unbind()
+{
+   m_impl->unbind();
+}
+
 void TsSqlStatement::setParam(int column, const TsSqlVariant &param)
 {
    m_impl->setParam(column, param);
@@ -638,11 +1322,81 @@ bool TsSqlStatement::fetchRow(TsSqlRow &row)
    return m_impl->fetchRow(row);
 }
 
+int TsSqlStatement::fetchColumns(TsSqlColumnarBuffer &buffer, int maxRows)
+{
+   return m_impl->fetchColumns(buffer, maxRows);
+}
+
+int TsSqlStatement::fetchRows(TsSqlRowBatch &rows, int maxRows)
+{
+   return m_impl->fetchRows(rows, maxRows);
+}
+
 void TsSqlStatement::stopFetching()
 {
    return m_impl->stopFetching();
 }
 
+bool TsSqlStatement::cancel()
+{
+   return m_impl->cancel();
+}
+
+void TsSqlStatement::setFetchBatchSize(int rows)
+{
+   m_impl->setFetchBatchSize(rows);
+}
+
+void TsSqlStatement::setFetchBatchTime(int msecs)
+{
+   m_impl->setFetchBatchTime(msecs);
+}
+
+int TsSqlStatement::fetchBatchSize()
+{
+   return m_impl->fetchBatchSize();
+}
+
+int TsSqlStatement::fetchBatchTime()
+{
+   return m_impl->fetchBatchTime();
+}
+
+void TsSqlStatement::setFetchReadAhead(int rows)
+{
+   m_impl->setFetchReadAhead(rows);
+}
+
+int TsSqlStatement::fetchReadAhead()
+{
+   return m_impl->fetchReadAhead();
+}
+
+QByteArray TsSqlStatement::loadBlobWaiting(const TsSqlBlobId &id, bool *ok)
+{
+   return m_impl->loadBlobWaiting(id, ok);
+}
+
+void TsSqlStatement::setFetchBlobIds(bool blobIds)
+{
+   m_impl->setFetchBlobIds(blobIds);
+}
+
+bool TsSqlStatement::fetchBlobIds()
+{
+   return m_impl->fetchBlobIds();
+}
+
+QVector<TsSqlColumnInfo> TsSqlStatement::columns()
+{
+   return m_impl->columns();
+}
+
+QVector<TsSqlColumnInfo> TsSqlStatement::params()
+{
+   return m_impl->params();
+}
+
 int TsSqlStatement::columnCount()
 {
    return m_impl->columnCount();
@@ -688,3 +1442,127 @@ int TsSqlStatement::columnScale(int columnIndex)
    return m_impl->columnScale(columnIndex);
 }
 
+int TsSqlStatement::paramCount()
+{
+   return m_impl->paramCount();
+}
+
+TsSqlType TsSqlStatement::paramType(int paramIndex)
+{
+   return m_impl->paramType(paramIndex);
+}
+
+int TsSqlStatement::paramSubType(int paramIndex)
+{
+   return m_impl->paramSubType(paramIndex);
+}
+
+int TsSqlStatement::paramSize(int paramIndex)
+{
+   return m_impl->paramSize(paramIndex);
+}
+
+int TsSqlStatement::paramScale(int paramIndex)
+{
+   return m_impl->paramScale(paramIndex);
+}
+
+
+TsSqlBlobReader::TsSqlBlobReader(
+   TsSqlDatabase &database,
+   TsSqlTransaction &transaction,
+   const TsSqlBlobId &id):
+   m_impl(new TsSqlBlobReaderImpl(
+            *database.m_impl,
+            *transaction.m_impl,
+            id))
+{
+   connect(
+      m_impl, 
+      SIGNAL(progress(qint64, qint64)), 
+      this, 
+      SIGNAL(progress(qint64, qint64)));
+   connect(m_impl, SIGNAL(finished()),     this, SIGNAL(finished()));
+   connect(m_impl, SIGNAL(error(QString)), this, SIGNAL(error(QString)));
+}
+
+TsSqlBlobReader::~TsSqlBlobReader()
+{
+   delete m_impl;
+}
+
+int TsSqlBlobReader::size()
+{
+   return m_impl->size();
+}
+
+int TsSqlBlobReader::readWaiting(char *data, int maxSize)
+{
+   return m_impl->readWaiting(data, maxSize);
+}
+
+QByteArray TsSqlBlobReader::readAllWaiting()
+{
+   return m_impl->readAllWaiting();
+}
+
+void TsSqlBlobReader::read(QIODevice *device, int chunkSize)
+{
+   m_impl->read(device, chunkSize);
+}
+
+void TsSqlBlobReader::stop()
+{
+   m_impl->stop();
+}
+
+TsSqlBlobWriter::TsSqlBlobWriter(
+   TsSqlDatabase &database,
+   TsSqlTransaction &transaction):
+   m_impl(new TsSqlBlobWriterImpl(
+            *database.m_impl,
+            *transaction.m_impl))
+{
+   connect(
+      m_impl, 
+      SIGNAL(progress(qint64, qint64)), 
+      this, 
+      SIGNAL(progress(qint64, qint64)));
+   connect(m_impl, SIGNAL(finished()),     this, SIGNAL(finished()));
+   connect(m_impl, SIGNAL(error(QString)), this, SIGNAL(error(QString)));
+}
+
+TsSqlBlobWriter::~TsSqlBlobWriter()
+{
+   delete m_impl;
+}
+
+qint64 TsSqlBlobWriter::size()
+{
+   return m_impl->size();
+}
+
+void TsSqlBlobWriter::writeWaiting(const char *data, int size)
+{
+   m_impl->writeWaiting(data, size);
+}
+
+void TsSqlBlobWriter::write(QIODevice *device, int chunkSize)
+{
+   m_impl->write(device, chunkSize);
+}
+
+bool TsSqlBlobWriter::writeFile(const QString &fileName, int chunkSize)
+{
+   return m_impl->writeFile(fileName, chunkSize);
+}
+
+void TsSqlBlobWriter::stop()
+{
+   m_impl->stop();
+}
+
+TsSqlBlobId TsSqlBlobWriter::closeWaiting()
+{
+   return m_impl->closeWaiting();
+}
@@ -2,6 +2,7 @@
 #define TS_DATABASE_H_27_08_2008
 
 #include <QDate>
+#include <QByteArray>
 #include <QTime>
 #include <QMutex>
 #include <QObject>
@@ -9,6 +10,7 @@
 #include <QVector>
 #include <QVariant>
 #include <QDateTime>
+#include <QIODevice>
 
 enum TsSqlType
 {
@@ -22,21 +24,45 @@ enum TsSqlType
    stInt,
    stLargeInt,
    stFloat,
-   stDouble
+   stDouble,
+   stBlobId, // a blob's id instead of it's content, see TsSqlBlobReader
+   stArray   // the elements of a numeric array, as doubles
 };
 
 typedef short     TsSqlSmallInt;
 typedef int       TsSqlInt;
 typedef long long TsSqlLargeInt;
 
+// Dates and times are stored the way Firebird stores them, so a
+// TsSqlVariant never needs to allocate memory for them.
+struct TsSqlTimeStampData
+{
+   int      date; // days since 17.11.1858
+   unsigned time; // 1/10000 seconds since midnight
+};
+
+// Identifies a blob in the database, as Firebird does. It can only be
+// read within the transaction it was fetched in.
+struct TsSqlBlobId
+{
+   int      high;
+   unsigned low;
+};
+Q_DECLARE_METATYPE(TsSqlBlobId);
+
 union TsSqlVariantData
 {
-   void         *asPointer;
-   TsSqlSmallInt asInt16;
-   TsSqlInt      asInt32;
-   TsSqlLargeInt asInt64;
-   float         asFloat;
-   double        asDouble;
+   void              *asPointer; // aligns asShared
+   TsSqlSmallInt      asInt16;
+   TsSqlInt           asInt32;
+   TsSqlLargeInt      asInt64;
+   float              asFloat;
+   double             asDouble;
+   TsSqlTimeStampData asTimeStamp;
+   TsSqlBlobId        asBlobId;
+   // A QString, QByteArray or QVector<double>, constructed in place. Both are implicitly
+   // shared, so copying them only increments a reference count.
+   char               asShared[sizeof(void*)];
 };
 
 class TsSqlVariant
@@ -44,17 +70,33 @@ class TsSqlVariant
    private:
       TsSqlVariantData m_data;
       TsSqlType m_type;
-      bool      m_delete;
-      template<typename T>
-         void newValue(const T &value, TsSqlType type);
-      friend void setFromStatement(TsSqlVariant &variant, void *statement, int column);
+      QString          &sharedString();
+      const QString    &sharedString() const;
+      QByteArray       &sharedData();
+      const QByteArray &sharedData()   const;
+      QVector<double>       &sharedArray();
+      const QVector<double> &sharedArray() const;
+      void copyValue(const TsSqlVariant &copy);
+      void setDateTime(TsSqlType type, int date, unsigned time);
+      friend void setFromStatement(
+         TsSqlVariant &variant, 
+         void *statement, 
+         int column, 
+         bool blobIds);
       friend void setStatementParam(const TsSqlVariant &variant, void *statement, int column);
+      friend class TsSqlColumnarBuffer;
    public:
       TsSqlVariant();
       template<typename T>
          TsSqlVariant(const T &value);
       TsSqlVariant(const TsSqlVariant &copy);
+#ifdef Q_COMPILER_RVALUE_REFS
+      TsSqlVariant(TsSqlVariant &&other);
+      TsSqlVariant &operator=(TsSqlVariant &&other);
+#endif
       ~TsSqlVariant();
+      TsSqlVariant &operator=(const TsSqlVariant &copy);
+      void swap(TsSqlVariant &other);
       TsSqlType type() const;
 
       bool isNull() const;
@@ -62,7 +104,18 @@ class TsSqlVariant
       void setVariant  (const QVariant &value);
       template<typename T>
          void set(const T &value);
-      void set(float value); // floats will not be handled by setVariant
+      void set(const QString    &value);
+      void set(const QByteArray &value);
+      void set(const QDate      &value);
+      void set(const QTime      &value);
+      void set(const QDateTime  &value);
+      void set(TsSqlSmallInt     value);
+      void set(TsSqlInt          value);
+      void set(TsSqlLargeInt     value);
+      void set(float             value); // floats will not be handled by setVariant
+      void set(double            value);
+      void set(const TsSqlBlobId &value);
+      void set(const QVector<double> &value);
 
       QVariant      asVariant()   const;
       QByteArray    asData()      const;
@@ -75,6 +128,8 @@ class TsSqlVariant
       QDateTime     asTimeStamp() const;
       QDate         asDate()      const;
       QTime         asTime()      const;
+      TsSqlBlobId   asBlobId()    const;
+      QVector<double> asArray()   const;
       template<typename T>
          TsSqlVariant &operator=(const T &value);
 };
@@ -83,6 +138,78 @@ Q_DECLARE_METATYPE(TsSqlVariant);
 typedef QVector<TsSqlVariant> TsSqlRow;
 Q_DECLARE_METATYPE(TsSqlRow);
 
+typedef QVector<TsSqlRow> TsSqlRowBatch;
+Q_DECLARE_METATYPE(TsSqlRowBatch);
+
+// The types of the variables TsSqlStatement::bind() accepts
+template<typename T> struct TsSqlTypeOf;
+template<> struct TsSqlTypeOf<TsSqlSmallInt>      { enum { type = stSmallInt  }; };
+template<> struct TsSqlTypeOf<TsSqlInt>           { enum { type = stInt       }; };
+template<> struct TsSqlTypeOf<TsSqlLargeInt>      { enum { type = stLargeInt  }; };
+template<> struct TsSqlTypeOf<float>              { enum { type = stFloat     }; };
+template<> struct TsSqlTypeOf<double>             { enum { type = stDouble    }; };
+template<> struct TsSqlTypeOf<QByteArray>         { enum { type = stString    }; };
+template<> struct TsSqlTypeOf<TsSqlTimeStampData> { enum { type = stTimeStamp }; };
+
+// The error of one parameter-row passed to TsSqlStatement::executeBatch().
+struct TsSqlBatchError
+{
+   int     row; // index into the batch
+   QString message;
+   TsSqlBatchError(): row(-1) {}
+   TsSqlBatchError(int row, const QString &message): row(row), message(message) {}
+};
+typedef QVector<TsSqlBatchError> TsSqlBatchErrors;
+Q_DECLARE_METATYPE(TsSqlBatchErrors);
+
+// Stores a result set column by column, each column in one contiguous
+// array of it's type, so scans and aggregations run over plain arrays.
+// Strings and blobs of a column are stored back to back in one byte array,
+// dates and times in Firebird's encoding (see TsSqlTimeStampData).
+// This class is NOT thread-safe. It is filled by
+// TsSqlStatement::fetchColumns(), which blocks until it is done.
+// Statements with array columns are refused by fetchColumns(), as are
+// statements with other column types than the rows already stored
+// (clear() the buffer first).
+class TsSqlColumnarBuffer
+{
+   private:
+      class TsSqlColumnarBufferImpl *m_impl;
+      friend void appendFromStatement(TsSqlColumnarBuffer &buffer, void *statement);
+      TsSqlColumnarBuffer(const TsSqlColumnarBuffer &);
+      TsSqlColumnarBuffer &operator=(const TsSqlColumnarBuffer &);
+   public:
+      TsSqlColumnarBuffer();
+      ~TsSqlColumnarBuffer();
+      void clear();
+      int       rowCount()    const;
+      int       columnCount() const;
+      QString   columnName(int column) const;
+      TsSqlType columnType(int column) const;
+      bool      isNull(int row, int column) const;
+
+      // The arrays returned here stay valid until the buffer is changed.
+      // They are 0 if the column has a different type.
+      // Bit (row % 32) of nullBitmap(column)[row / 32] is set for NULL.
+      const quint32            *nullBitmap   (int column) const;
+      const TsSqlSmallInt      *int16Column  (int column) const;
+      const TsSqlInt           *int32Column  (int column) const;
+      const TsSqlLargeInt      *int64Column  (int column) const;
+      const float              *floatColumn  (int column) const;
+      const double             *doubleColumn (int column) const;
+      const TsSqlTimeStampData *timeStampColumn(int column) const; // dates and times, too
+      // For strings and blobs, value i is stored in the bytes
+      // from stringOffsets()[i] up to stringOffsets()[i + 1].
+      const char               *stringData   (int column) const;
+      const int                *stringOffsets(int column) const;
+
+      // Row-oriented view, creates the values on each call
+      TsSqlVariant value(int row, int column) const;
+      TsSqlRow     row(int row) const;
+};
+
+typedef void (*TsSqlRowVisitor)(const TsSqlRow &row, void *context);
+
 // This class is thread-safe!
 // Hence it has a rather cumbersome API to get and set elements.
 class TsSqlBuffer: public QObject
@@ -91,6 +218,8 @@ class TsSqlBuffer: public QObject
    private:
       class TsSqlBufferImpl *m_impl;
       void connectSignals();
+      template<typename F>
+         static void visitRow(const TsSqlRow &row, void *visitor);
    public:
       // A buffer can either have one statement for data and row retrieval
       // or use one statement to fetch primary keys and another to fetch the
@@ -111,16 +240,65 @@ class TsSqlBuffer: public QObject
       // It COPIES the row, otherwise it was not thread-safe.
       TsSqlRow getRow(unsigned index);
       void setRow(unsigned index, const TsSqlRow &row);
+      // A single value, read in place without copying the row. Only this
+      // cell's blob is loaded with lazyBlobs(). Rows outside of the buffer,
+      // e.g. deleted meanwhile, are empty.
+      TsSqlVariant cell(unsigned row, unsigned column);
+      TsSqlVariant value(unsigned row, unsigned column); // the same as cell()
+      // Calls visitor(const TsSqlRow &) with the row in place, under a
+      // shared lock, instead of copying it. The visitor must not call the
+      // buffer. With lazyBlobs() it gets a copy with the blobs loaded.
+      // It isn't called for a row outside of the buffer. The visitor may
+      // be a temporary, its operator() needn't be const.
+      template<typename F>
+         void withRow(unsigned row, const F &visitor);
+      void withRow(unsigned row, TsSqlRowVisitor visitor, void *context);
       unsigned count() const;
       unsigned columnCount() const;
+      // If set, the data statement fetches blobs as ids, which are loaded
+      // when the values of a row are asked for. Up to cacheSize bytes of
+      // loaded blobs are kept, the least recently used are dropped first.
+      // A blob that fails to load stays an id and is tried again next time.
+      // Must be set before the data statement is executed.
+      void setLazyBlobs(bool lazy, int cacheSize = 1024 * 1024);
+      bool lazyBlobs() const;
       class TsSqlStatement *dataStatement();
       class TsSqlStatement *fetchStatement();
+      // With two statements, rows are resolved by the data statement one
+      // key at a time. If a batch statement is set, the unresolved rows
+      // around a requested one are resolved batchSize keys at once instead.
+      // It must be prepared with batchSize key parameters, e.g.
+      // "... WHERE ID IN (?, ?, ?)" or a join with a set of keys, and return
+      // the key in it's first column, like the data statement. Parameters
+      // left over in the last batch repeat a key.
+      // The background prefetch (see setViewport()) needs a statement of
+      // it's own, prepared like the batch statement and used by nothing
+      // else, as it runs while other threads resolve rows on demand.
+      void setBatchStatement(
+         class TsSqlStatement *batchStatement,
+         int batchSize,
+         class TsSqlStatement *prefetchStatement = 0);
+      class TsSqlStatement *batchStatement();
+      class TsSqlStatement *prefetchStatement();
+      int batchSize() const;
+      // Rows first to last are visible. The unresolved ones among them, and
+      // those up to prefetchMargin() rows below and above them, are resolved
+      // in the background by the prefetch statement, one batch at a time.
+      // Each batch is announced by rowsResolved().
+      void setViewport(unsigned first, unsigned last);
+      void setPrefetchMargin(unsigned rows); // 100 by default
+      unsigned prefetchMargin() const;
+      // Doesn't block: false, while the row's data has not been fetched
+      bool isResolved(unsigned row) const;
    signals:
       void cleared();
       void rowAppended();
-      void rowDeleted();
+      void rowDeleted(unsigned index);
       void columnsChanged();
       void rowFetched(TsSqlRow row);
+      void rowsResolved(unsigned first, unsigned last);
+      // Once for each batch of rows the statement fetched
+      void rowsAppended(unsigned first, unsigned last);
 };
 
 class TsSqlDatabase: public QObject
@@ -130,6 +308,9 @@ class TsSqlDatabase: public QObject
       class TsSqlDatabaseImpl *m_impl;
       friend class TsSqlTransaction;
       friend class TsSqlStatement;
+      friend class TsSqlBlobReader;
+      friend class TsSqlBlobWriter;
+      friend class TsSqlConnectionPoolImpl;
    public:
       TsSqlDatabase(
          const QString &server,
@@ -140,12 +321,33 @@ class TsSqlDatabase: public QObject
          const QString &role         = QString(),
          const QString &createParams = QString());
       ~TsSqlDatabase();
+      // All databases share up to count threads, which execute their
+      // requests. Affects databases created afterwards, only.
+      // Defaults to QThread::idealThreadCount().
+      static void setWorkerThreads(int count);
+      static int  workerThreads();
       void test();   // some test-functions for development, only
       void open();   // async
       void close();  // async
       void openWaiting();  // sync
       void closeWaiting(); // sync
       bool isOpen();
+      bool ping(); // sync, false if the server can't be reached
+      // Interrupts the operation running on the database-thread, which
+      // then emits cancelled() from the database or statement whose request
+      // it was. May be called from any thread and does not wait.
+      // Returns false if nothing was cancelled or the client library
+      // can't cancel (Firebird 2.5 is required).
+      bool cancel();
+      // Statements prepared from SQL-text are kept for reuse, up to size
+      // of them (32 by default), while their transaction exists. 0 disables
+      // this. The hits and misses count the preparations served by the
+      // cache and those which had to prepare the statement. A smaller size
+      // closes the statements beyond it on the database-thread.
+      void setStatementCacheSize(int size); // async
+      int  statementCacheSize();
+      int  statementCacheHits();
+      int  statementCacheMisses();
       QString server();
       QString database();
       QString user();
@@ -157,15 +359,105 @@ class TsSqlDatabase: public QObject
    signals:
       void opened();
       void closed();
+      void cancelled();
       void error(const QString &errorMessage);
 };
 
+// Keeps opened databases for reuse, one set per server, database, user,
+// password, character set and role. acquire() hands out an opened database,
+// which has to be given back by release(), TsSqlConnectionLease does that
+// automatically. A database is thread-less while it is idle in the pool and
+// delivers it's signals to the thread, which acquired it.
+// This class is thread-safe!
+class TsSqlConnectionPool
+{
+   private:
+      class TsSqlConnectionPoolImpl *m_impl;
+      TsSqlConnectionPool(const TsSqlConnectionPool &);
+      TsSqlConnectionPool &operator=(const TsSqlConnectionPool &);
+   public:
+      struct Statistics
+      {
+         int    hits;     // acquires served by an idle database
+         int    misses;   // acquires which opened a new database
+         int    waits;    // acquires which waited for a release
+         int    timeouts; // acquires which gave up waiting
+         qint64 waitTime; // milliseconds spent waiting, in total
+         int    idle;
+         int    leased;
+      };
+
+      // Up to maximumSize databases are opened for each set, acquire()
+      // waits for a release when all of them are leased. Idle databases
+      // are closed after idleTimeout milliseconds, unless minimumSize
+      // databases would remain. Idle databases are pinged before they are
+      // handed out, once they have been idle longer than validationInterval.
+      TsSqlConnectionPool(
+         int minimumSize        = 0,
+         int maximumSize        = 8,
+         int idleTimeout        = 60000,
+         int validationInterval = 10000);
+      // Closes the idle databases, all leased ones must have been released.
+      ~TsSqlConnectionPool();
+      void setMinimumSize(int size);
+      void setMaximumSize(int size);
+      void setIdleTimeout(int msecs);
+      void setValidationInterval(int msecs);
+      int  minimumSize();
+      int  maximumSize();
+      int  idleTimeout();
+      int  validationInterval();
+
+      // Returns 0 if no database could be opened, or if none was released
+      // within timeout milliseconds (a negative timeout waits forever).
+      TsSqlDatabase *acquire(
+         const QString &server,
+         const QString &database,
+         const QString &user,
+         const QString &password,
+         const QString &characterSet = QString(),
+         const QString &role         = QString(),
+         int timeout = -1); // sync
+      void release(TsSqlDatabase *database);
+      // Closes databases idle for longer than the idle timeout.
+      // acquire() and release() do this, too.
+      void expire();
+      Statistics statistics();
+};
+
+// Acquires a database from a pool and releases it when destroyed.
+class TsSqlConnectionLease
+{
+   private:
+      TsSqlConnectionPool &m_pool;
+      TsSqlDatabase *m_database;
+      TsSqlConnectionLease(const TsSqlConnectionLease &);
+      TsSqlConnectionLease &operator=(const TsSqlConnectionLease &);
+   public:
+      TsSqlConnectionLease(
+         TsSqlConnectionPool &pool,
+         const QString &server,
+         const QString &database,
+         const QString &user,
+         const QString &password,
+         const QString &characterSet = QString(),
+         const QString &role         = QString(),
+         int timeout = -1); // sync
+      ~TsSqlConnectionLease();
+      bool isValid() const { return m_database != 0; }
+      TsSqlDatabase *database() const { return m_database; }
+      TsSqlDatabase *operator->() const { return m_database; }
+      void release();
+};
+
 class TsSqlTransaction: public QObject
 {
    Q_OBJECT
    private:
       class TsSqlTransactionImpl *m_impl;
       friend class TsSqlStatement;
+      friend class TsSqlBlobReader;
+      friend class TsSqlBlobWriter;
    public:
       enum TransactionMode
       {
@@ -192,12 +484,27 @@ class TsSqlTransaction: public QObject
 };
 Q_DECLARE_METATYPE(TsSqlTransaction::TransactionMode);
 
+// Describes a column or parameter of a prepared statement.
+// Parameters have no name, alias or table.
+struct TsSqlColumnInfo
+{
+   QString   name;
+   QString   alias;
+   QString   table;
+   TsSqlType type;
+   int       subType;
+   int       size;
+   int       scale;
+   TsSqlColumnInfo(): type(stUnknown), subType(0), size(0), scale(0) {}
+};
+
 class TsSqlStatement: public QObject
 {
    Q_OBJECT
    private:
       class TsSqlStatementImpl *m_impl;
       void connectSignals();
+      void bindParam(int column, TsSqlType type, const void *value, const bool *isNull);
    public:
       TsSqlStatement(TsSqlDatabase &database, TsSqlTransaction &transaction);
       TsSqlStatement(TsSqlDatabase &database, TsSqlTransaction &transaction, const QString &sql);
@@ -218,15 +525,77 @@ class TsSqlStatement: public QObject
       void executeWaiting(const TsSqlRow &params); // sync
       void executeWaiting(const QString &sql, const TsSqlRow &params); // sync
 
+      // Executes the prepared statement once for each row of params, all
+      // in one request to the database-thread. A failing row does not stop
+      // the batch, it's error is reported together with the total of the
+      // affected rows in batchExecuted() or by executeBatchWaiting().
+      void executeBatch(const TsSqlRowBatch &params); // async
+      int  executeBatchWaiting(
+         const TsSqlRowBatch &params,
+         TsSqlBatchErrors *errors = 0); // sync, returns the affected rows
+
       void setParam(int column, const TsSqlVariant &param); // sync
 
+      // Binds parameter column to the caller's variable at value, which
+      // must stay valid until unbind(). Each execute() without params reads
+      // the bound variables when the database-thread executes the
+      // statement and copies them into it, without converting them if they
+      // match the parameter's type. Strings are bound as a QByteArray in
+      // the connection's character set, dates and times as the matching
+      // part of a TsSqlTimeStampData. While *isNull is true, NULL is passed.
+      template<typename T>
+         void bind(int column, const T *value, const bool *isNull = 0);
+      void unbind();
+
       QString sql();
       QString plan();
       int affectedRows();
       void fetch();                 // async
       bool fetchRow(TsSqlRow &row); // sync
+      // Appends up to maxRows (or all remaining, if negative) rows to buffer
+      // and returns the number of appended rows.
+      int  fetchColumns(TsSqlColumnarBuffer &buffer, int maxRows = -1); // sync
+      // The same for rows, which are appended to rows
+      int  fetchRows(TsSqlRowBatch &rows, int maxRows = -1); // sync
       void stopFetching();          // async
+      // Interrupts a running execute or fetch, even within a single row,
+      // see TsSqlDatabase::cancel().
+      bool cancel();                // any thread
+      // Loads a blob this statement fetched as an id, in it's transaction.
+      // If it fails, error() is emitted and *ok (if given) is set to false.
+      QByteArray loadBlobWaiting(const TsSqlBlobId &id, bool *ok = 0); // sync
+
+      // While fetching asynchronously, the database-thread collects up to
+      // rows datasets (or fetches for up to msecs milliseconds, if msecs is
+      // greater than 0) before it delivers them in one fetchedBatch()-signal.
+      // The default of 1 row delivers each dataset on it's own.
+      void setFetchBatchSize(int rows);   // sync
+      void setFetchBatchTime(int msecs);  // sync
+      int  fetchBatchSize();
+      int  fetchBatchTime();
+
+      // With a read-ahead of more than 0 rows, fetch() does not wait for
+      // the receivers of fetched() before it fetches the next row.
+      // The database-thread keeps fetching until rows datasets are
+      // waiting to be delivered and continues when half of them have been.
+      // Must not be changed while fetching.
+      void setFetchReadAhead(int rows);
+      int  fetchReadAhead();
+
+      // If set, fetched blob columns hold only the blob's id (stBlobId),
+      // to be read by a TsSqlBlobReader, instead of their whole content.
+      // Must not be changed while fetching.
+      void setFetchBlobIds(bool blobIds);
+      bool fetchBlobIds();
 
+      // Columns and parameters are described once after each prepare,
+      // none of these wait for the database-thread. They describe the
+      // statement the database-thread prepared last: right after
+      // prepareWaiting() or executeWaiting(sql), but after an async
+      // prepare() or execute(sql) only once prepared() was emitted.
+      // Until then they may still describe the previous statement.
+      QVector<TsSqlColumnInfo> columns();
+      QVector<TsSqlColumnInfo> params();
       int        columnCount();
       QString    columnName(   int columnIndex);
       int        columnIndex(  const QString &columnName);
@@ -236,31 +605,94 @@ class TsSqlStatement: public QObject
       int        columnSubType(int columnIndex);
       int        columnSize   (int columnIndex);
       int        columnScale  (int columnIndex);
+      int        paramCount();
+      TsSqlType  paramType(   int paramIndex);
+      int        paramSubType(int paramIndex);
+      int        paramSize   (int paramIndex);
+      int        paramScale  (int paramIndex);
    signals:
       void prepared();
       void executed();
+      void batchExecuted(int affectedRows, TsSqlBatchErrors errors);
       void fetchStarted();
       void fetched(TsSqlRow row);
+      void fetchedBatch(TsSqlRowBatch rows);
       void fetchFinished();
+      void cancelled();
       void error(const QString &errorMessage);
 };
 
-/* Template-Implementations */
-template<typename T>
-TsSqlVariant::TsSqlVariant(const T &value):
-   m_type(stUnknown),
-   m_delete(false)
+// Reads a blob, fetched as a TsSqlBlobId, piece by piece on the
+// database-thread, so it never needs to be in memory as a whole.
+// The blob is opened on construction and read from it's start to it's end.
+class TsSqlBlobReader: public QObject
 {
-   m_data.asPointer = 0;
-   setVariant(QVariant(value));
-}
+   Q_OBJECT
+   private:
+      class TsSqlBlobReaderImpl *m_impl;
+   public:
+      TsSqlBlobReader(
+         TsSqlDatabase &database,
+         TsSqlTransaction &transaction,
+         const TsSqlBlobId &id);
+      ~TsSqlBlobReader();
+      int size(); // in bytes
+
+      // Reads up to maxSize bytes into data and returns their number,
+      // which is 0 at the end of the blob.
+      int readWaiting(char *data, int maxSize); // sync
+      // Reads the rest of the blob into a buffer allocated at it's final size
+      QByteArray readAllWaiting(); // sync
+      // Writes the rest of the blob to device, chunkSize bytes at a time,
+      // and emits progress() after each chunk. The device is written by the
+      // database-thread, so it must not be used until finished().
+      void read(QIODevice *device, int chunkSize = 64 * 1024); // async
+      void stop(); // async, read() finishes after the current chunk
+   signals:
+      void progress(qint64 bytesRead, qint64 size);
+      void finished();
+      void error(const QString &errorMessage);
+};
+
+// Writes a new blob piece by piece on the database-thread, so it never
+// needs to be in memory as a whole. Once closed, it's id is passed as a
+// parameter of a statement in the same transaction.
+class TsSqlBlobWriter: public QObject
+{
+   Q_OBJECT
+   private:
+      class TsSqlBlobWriterImpl *m_impl;
+   public:
+      TsSqlBlobWriter(TsSqlDatabase &database, TsSqlTransaction &transaction);
+      ~TsSqlBlobWriter(); // discards the blob, unless it was closed
+      qint64 size(); // bytes written, not to be called while write() is running
 
+      // Appends size bytes of data, may be called repeatedly to write the
+      // blob from any source
+      void writeWaiting(const char *data, int size); // sync
+      // Appends all data up to device's end, chunkSize bytes at a time, and
+      // emits progress() after each chunk. The device is read by the
+      // database-thread, so it must not be used until finished().
+      void write(QIODevice *device, int chunkSize = 64 * 1024); // async
+      // Like write(), with the file fileName. Returns false if it can't be opened.
+      bool writeFile(const QString &fileName, int chunkSize = 64 * 1024); // async
+      void stop(); // async, write() finishes after the current chunk
+      // Closes the blob and returns it's id, it can't be written anymore
+      TsSqlBlobId closeWaiting(); // sync
+   signals:
+      // size is -1 if the device's size is unknown
+      void progress(qint64 bytesWritten, qint64 size);
+      void finished();
+      void error(const QString &errorMessage);
+};
+
+/* Template-Implementations */
 template<typename T>
-void TsSqlVariant::newValue(const T &value, TsSqlType type)
+TsSqlVariant::TsSqlVariant(const T &value):
+   m_type(stUnknown)
 {
-   m_data.asPointer = new T(value);
-   m_type = type;
-   m_delete = true;
+   m_data.asInt64 = 0;
+   set(value);
 }
 
 template<typename T>
@@ -276,4 +708,22 @@ TsSqlVariant &TsSqlVariant::operator=(const T &value)
    return *this;
 }
 
+template<typename T>
+void TsSqlStatement::bind(int column, const T *value, const bool *isNull)
+{
+   bindParam(column, TsSqlType(TsSqlTypeOf<T>::type), value, isNull);
+}
+
+template<typename F>
+void TsSqlBuffer::visitRow(const TsSqlRow &row, void *visitor)
+{
+   (*static_cast<F*>(visitor))(row);
+}
+
+template<typename F>
+void TsSqlBuffer::withRow(unsigned row, const F &visitor)
+{
+   withRow(row, &TsSqlBuffer::visitRow<F>, const_cast<F*>(&visitor));
+}
+
 #endif
@@ -1,6 +1,9 @@
 #include <algorithm>
+#include <climits>
+#include <stdexcept>
 
 #include <QDebug>
+#include <QCoreApplication>
 
 #include "private/ibpp/core/ibpp.h"
 
@@ -9,18 +12,128 @@
 
 #define DEBUG_LOG(message) qDebug() << "Thread [" << QThread::currentThreadId() << "] " << message
 
+TsSqlColumnarBufferImpl::TsSqlColumnarBufferImpl():
+   m_rowCount(0)
+{
+}
+
+void TsSqlColumnarBufferImpl::clear()
+{
+   m_rowCount = 0;
+   m_columns.clear();
+}
+
+void TsSqlColumnarBufferImpl::setColumns(
+   const QVector<QString> &names,
+   const QVector<TsSqlType> &types)
+{
+   clear();
+   m_columns.resize(types.size());
+   for(int i = 0; i < types.size(); ++i)
+   {
+      m_columns[i].name = names[i];
+      m_columns[i].type = types[i];
+      if (types[i] == stString || types[i] == stBlob)
+         m_columns[i].offsets.append(0);
+   }
+}
+
+void TsSqlColumnarBufferImpl::setNull(int column, int row)
+{
+   m_columns[column].nulls[row / 32] |= 1u << (row % 32);
+}
+
+// Drops the values of the rows from rowCount on, which may be incomplete
+void TsSqlColumnarBufferImpl::truncate(int rowCount)
+{
+   for(int i = 0; i < m_columns.size(); ++i)
+   {
+      TsSqlColumnData &col = m_columns[i];
+      int size;
+      switch(col.type)
+      {
+         case stString:
+         case stBlob:
+            col.offsets.resize(qMin(col.offsets.size(), rowCount + 1));
+            size = col.offsets.last();
+            break;
+         case stDate:
+         case stTime:
+         case stTimeStamp:
+            size = rowCount * sizeof(TsSqlTimeStampData);
+            break;
+         case stSmallInt:
+            size = rowCount * sizeof(TsSqlSmallInt);
+            break;
+         case stInt:
+            size = rowCount * sizeof(TsSqlInt);
+            break;
+         case stLargeInt:
+            size = rowCount * sizeof(TsSqlLargeInt);
+            break;
+         case stFloat:
+            size = rowCount * sizeof(float);
+            break;
+         case stDouble:
+            size = rowCount * sizeof(double);
+            break;
+         default:
+            size = 0;
+            break;
+      }
+      col.values.resize(qMin(col.values.size(), size));
+      col.nulls.resize(qMin(col.nulls.size(), (rowCount + 31) / 32));
+      if (rowCount % 32 != 0 && !col.nulls.isEmpty())
+         col.nulls.last() &= (1u << (rowCount % 32)) - 1;
+   }
+   m_rowCount = rowCount;
+}
+
+void TsSqlColumnarBufferImpl::appendString(int column, const char *data, int size)
+{
+   TsSqlColumnData &col = m_columns[column];
+   int offset = col.values.size();
+   col.values.resize(offset + size);
+   memcpy(col.values.data() + offset, data, size);
+   col.offsets.append(offset + size);
+}
+
 TsSqlBufferImpl::TsSqlBufferImpl():
+   m_count(0),
+   m_batchBusy(0),
    m_data(0),
    m_fetch(0),
-   m_colCount(0)
+   m_batch(0),
+   m_prefetch(0),
+   m_batchSize(0),
+   m_viewFirst(0),
+   m_viewLast(0),
+   m_margin(100),
+   m_prefetching(false),
+   m_prefetchRetried(false),
+   m_colCount(0),
+   m_lazyBlobs(false),
+   m_blobCache(1024 * 1024)
 {
    setStatements(0, 0);
 }
 
 TsSqlBufferImpl::TsSqlBufferImpl(TsSqlStatement &dataStatement):
+   m_count(0),
+   m_batchBusy(0),
    m_data(0),
    m_fetch(0),
-   m_colCount(0)
+   m_batch(0),
+   m_prefetch(0),
+   m_batchSize(0),
+   m_viewFirst(0),
+   m_viewLast(0),
+   m_margin(100),
+   m_prefetching(false),
+   m_prefetchRetried(false),
+   m_colCount(0),
+   m_lazyBlobs(false),
+   m_blobCache(1024 * 1024)
 {
    setStatements(&dataStatement);
 }
@@ -28,19 +141,74 @@ TsSqlBufferImpl::TsSqlBufferImpl(TsSqlStatement &dataStatement):
 TsSqlBufferImpl::TsSqlBufferImpl(
    TsSqlStatement &dataStatement, 
    TsSqlStatement &fetchStatement):
+   m_count(0),
+   m_batchBusy(0),
    m_data(0),
    m_fetch(0),
-   m_colCount(0)
+   m_batch(0),
+   m_prefetch(0),
+   m_batchSize(0),
+   m_viewFirst(0),
+   m_viewLast(0),
+   m_margin(100),
+   m_prefetching(false),
+   m_prefetchRetried(false),
+   m_colCount(0),
+   m_lazyBlobs(false),
+   m_blobCache(1024 * 1024)
 {
    setStatements(&dataStatement, &fetchStatement);
 }
 
-TsSqlBufferImpl::TsSqlBufferImpl(const TsSqlBufferImpl &copy): QObject(0)
+TsSqlBufferImpl::TsSqlBufferImpl(const TsSqlBufferImpl &copy): 
+   QObject(0),
+   m_count(0),
+   m_batchBusy(0),
+   m_data(0),
+   m_fetch(0),
+   m_batch(0),
+   m_prefetch(0),
+   m_batchSize(0),
+   m_viewFirst(copy.m_viewFirst),
+   m_viewLast(copy.m_viewLast),
+   m_margin(copy.m_margin),
+   m_prefetching(false),
+   m_prefetchRetried(false),
+   m_colCount(copy.m_colCount),
+   m_lazyBlobs(copy.m_lazyBlobs),
+   m_blobCache(copy.m_blobCache.maxCost())
 {
-   QMutexLocker lock(&m_mutex);
-   QMutexLocker lockCopy(&copy.m_mutex);
-   m_rows = copy.m_rows;
+   {
+      QReadLocker lockCopy(&copy.m_lock);
+      m_chunks.reserve(copy.m_chunks.size());
+      for(int i = 0; i < copy.m_chunks.size(); ++i)
+         m_chunks.append(new TsSqlBufferChunk(*copy.m_chunks.at(i)));
+      m_count.fetchAndStoreRelease(copy.count());
+   }
    setStatements(copy.m_data, copy.m_fetch);
+   setBatchStatement(copy.m_batch, copy.m_batchSize, copy.m_prefetch);
+}
+
+TsSqlBufferImpl::~TsSqlBufferImpl()
+{
+   freeChunks();
+}
+
+inline TsSqlBufferItem &TsSqlBufferImpl::item(unsigned row)
+{
+   return m_chunks.at(row / TsSqlBufferChunk::size)->items[row % TsSqlBufferChunk::size];
+}
+
+inline const TsSqlBufferItem &TsSqlBufferImpl::item(unsigned row) const
+{
+   return m_chunks.at(row / TsSqlBufferChunk::size)->items[row % TsSqlBufferChunk::size];
+}
+
+void TsSqlBufferImpl::freeChunks()
+{
+   qDeleteAll(m_chunks);
+   m_chunks.clear();
+   m_count.fetchAndStoreRelease(0);
 }
 
 void TsSqlBufferImpl::setStatements(
@@ -56,10 +224,20 @@ void TsSqlBufferImpl::setStatements(
       fetchStatement = 0;
    m_data  = dataStatement;
    m_fetch = fetchStatement;
+   {
+      QMutexLocker locker(&m_cacheMutex);
+      m_blobCache.clear();
+   }
+   if (m_data && m_lazyBlobs)
+      m_data->setFetchBlobIds(true);
+   if (m_batch && m_lazyBlobs)
+      m_batch->setFetchBlobIds(true);
+   if (m_prefetch && m_lazyBlobs)
+      m_prefetch->setFetchBlobIds(true);
    if (m_data && m_fetch)
-      connect(m_fetch, SIGNAL(fetched(TsSqlRow)), this, SLOT(appendEmptyRow(TsSqlRow)));
+      connect(m_fetch, SIGNAL(fetchedBatch(TsSqlRowBatch)), this, SLOT(appendEmptyRows(TsSqlRowBatch)));
    else if (dataStatement)
-      connect(m_data, SIGNAL(fetched(TsSqlRow)), this, SLOT(appendRow(TsSqlRow)));
+      connect(m_data, SIGNAL(fetchedBatch(TsSqlRowBatch)), this, SLOT(appendRows(TsSqlRowBatch)));
    connect(dataStatement, SIGNAL(prepared()), this, SLOT(updateColumnCount()));
 }
 
@@ -69,72 +247,476 @@ void TsSqlBufferImpl::updateColumnCount()
    emit columnsChanged();
 }
 
-void TsSqlBufferImpl::validateRow(unsigned row)
+// Fetches the data of an unresolved row, with the batch statement unless
+// another thread is using it. The lock is only held to read the keys and
+// to store the rows, never while waiting for the database. Rows outside
+// of the buffer (deleted meanwhile) are left alone.
+void TsSqlBufferImpl::resolve(unsigned row)
+{
+   {
+      QReadLocker locker(&m_lock);
+      if (row >= count() || item(row).first)
+         return;
+   }
+   if (m_batch && m_batchSize > 0 && m_batchBusy.testAndSetAcquire(0, 1))
+   {
+      resolveBatch(row);
+      m_batchBusy.fetchAndStoreRelease(0);
+   }
+   else
+      resolveSingle(row);
+}
+
+void TsSqlBufferImpl::resolveSingle(unsigned row)
 {
-   QPair<bool, TsSqlRow> &item = m_rows[row];
-   if (!item.first)
+   int key;
+   {
+      QReadLocker locker(&m_lock);
+      if (row >= count())
+         return;
+      key = item(row).second.value(0).asInt32();
+   }
+   TsSqlRow fetched;
    {
-      m_data->setParam(1, item.second[0].asInt32());
+      QMutexLocker locker(&m_dataMutex);
+      m_data->setParam(1, key);
       m_data->executeWaiting();
-      m_data->fetchRow(item.second);
-      item.first = true;
-      emit rowFetched(item.second);
+      m_data->fetchRow(fetched);
+   }
+   bool stored;
+   {
+      QWriteLocker locker(&m_lock);
+      stored = storeRow(row, key, fetched);
+   }
+   if (stored && !fetched.isEmpty())
+      emit rowFetched(fetched);
+}
+
+// Resolves up to m_batchSize unresolved rows with one execution of the
+// batch statement: row and those after it first, as views are mostly
+// scrolled down, then those before it. Only a few batches around row are
+// looked at, so resolved rows are not scanned from end to end.
+void TsSqlBufferImpl::resolveBatch(unsigned row)
+{
+   QHash<int, unsigned> index;
+   TsSqlRow params;
+   {
+      QReadLocker locker(&m_lock);
+      const int window = 4 * m_batchSize;
+      QVector<unsigned> rows;
+      rows.reserve(m_batchSize);
+      collectUnresolved(row, row + window - 1, rows);
+      collectUnresolved(int(row) - 1, int(row) - window, rows);
+      // Resolved by another thread meanwhile
+      if (rows.isEmpty())
+         return;
+      params = batchParams(rows, index);
+   }
+   m_batch->executeWaiting(params);
+   TsSqlRowBatch fetched;
+   m_batch->fetchRows(fetched);
+
+   TsSqlRowBatch stored;
+   {
+      QWriteLocker locker(&m_lock);
+      for(TsSqlRowBatch::const_iterator i = fetched.begin();
+          i != fetched.end();
+          ++i)
+         if (storeFetched(*i, index) >= 0)
+            stored.append(*i);
+      // Keys without a row (deleted meanwhile) are not asked for again
+      for(QHash<int, unsigned>::const_iterator i = index.begin();
+          i != index.end();
+          ++i)
+         storeRow(i.value(), i.key(), TsSqlRow());
+   }
+   for(TsSqlRowBatch::const_iterator i = stored.begin();
+       i != stored.end();
+       ++i)
+      emit rowFetched(*i);
+}
+
+// Appends the unresolved rows from first to last (backwards, if last is
+// less than first) to rows, until it holds m_batchSize of them. Rows
+// outside of the buffer are skipped.
+void TsSqlBufferImpl::collectUnresolved(int first, int last, QVector<unsigned> &rows)
+{
+   const int count = this->count();
+   const int step = first <= last ? 1 : -1;
+   for(int i = first; i != last + step && rows.size() < m_batchSize; i += step)
+      if (i >= 0 && i < count && !item(i).first)
+         rows.append(i);
+}
+
+// The keys of rows, as parameters of the batch statement. Parameters left
+// over repeat the last key.
+TsSqlRow TsSqlBufferImpl::batchParams(
+   const QVector<unsigned> &rows,
+   QHash<int, unsigned> &index)
+{
+   TsSqlRow params(m_batchSize);
+   for(int i = 0; i < m_batchSize; ++i)
+   {
+      unsigned row = rows[std::min(i, rows.size() - 1)];
+      params[i] = item(row).second.value(0);
+      index.insert(params[i].asInt32(), row);
+   }
+   return params;
+}
+
+// Stores the data fetched for row, unless the row was resolved, deleted or
+// moved meanwhile. Without data (the key's record is gone) the row is just
+// marked as resolved, so it is not asked for again.
+bool TsSqlBufferImpl::storeRow(unsigned row, int key, const TsSqlRow &data)
+{
+   if (row >= count())
+      return false;
+   TsSqlBufferItem &stored = item(row);
+   if (stored.first || stored.second.value(0).asInt32() != key)
+      return false;
+   stored.first = true;
+   if (!data.isEmpty())
+      stored.second = data;
+   return true;
+}
+
+// Stores a row fetched by the batch statement, returns it's index or -1 if
+// it's key was not asked for or the row is not waiting for it anymore.
+int TsSqlBufferImpl::storeFetched(const TsSqlRow &row, const QHash<int, unsigned> &index)
+{
+   int key = row.value(0).asInt32();
+   QHash<int, unsigned>::const_iterator found = index.find(key);
+   if (found == index.end() || !storeRow(found.value(), key, row))
+      return -1;
+   return found.value();
+}
+
+// Starts resolving the next batch of the viewport and it's margins on the
+// database-thread, unless one is under way: the visible rows first, then
+// those below and then those above them. The prefetch statement is used
+// by nothing else, so each of it's signals belongs to the prefetch. The
+// viewport and m_prefetching are guarded by m_lock, so only one thread
+// starts a prefetch.
+void TsSqlBufferImpl::schedulePrefetch()
+{
+   if (!m_fetch || !m_prefetch || m_batchSize <= 0)
+      return;
+   TsSqlRow params;
+   {
+      QWriteLocker locker(&m_lock);
+      if (m_prefetching)
+         return;
+      QVector<unsigned> rows;
+      const int first = m_viewFirst, last = m_viewLast, margin = m_margin;
+      collectUnresolved(first, last, rows);
+      collectUnresolved(last + 1, last + margin, rows);
+      collectUnresolved(first - 1, first - margin, rows);
+      if (rows.isEmpty())
+         return;
+      m_prefetching = true;
+      m_prefetchIndex.clear();
+      params = batchParams(rows, m_prefetchIndex);
+   }
+   m_prefetch->execute(params, true);
+}
+
+void TsSqlBufferImpl::prefetched(const TsSqlRowBatch &rows)
+{
+   int first = INT_MAX, last = -1;
+   {
+      QWriteLocker locker(&m_lock);
+      for(TsSqlRowBatch::const_iterator i = rows.begin();
+          i != rows.end();
+          ++i)
+      {
+         int row = storeFetched(*i, m_prefetchIndex);
+         if (row < 0)
+            continue;
+         first = std::min(first, row);
+         last  = std::max(last, row);
+      }
+   }
+   if (last >= 0)
+      emit rowsResolved(first, last);
+}
+
+void TsSqlBufferImpl::prefetchFinished()
+{
+   int first = INT_MAX, last = -1;
+   {
+      QWriteLocker locker(&m_lock);
+      if (!m_prefetching)
+         return;
+      // Keys without a row (deleted meanwhile) are not asked for again
+      for(QHash<int, unsigned>::const_iterator i = m_prefetchIndex.begin();
+          i != m_prefetchIndex.end();
+          ++i)
+      {
+         if (!storeRow(i.value(), i.key(), TsSqlRow()))
+            continue;
+         first = std::min(first, int(i.value()));
+         last  = std::max(last, int(i.value()));
+      }
+      m_prefetchIndex.clear();
+      m_prefetching = false;
+      m_prefetchRetried = false;
+   }
+   if (last >= 0)
+      emit rowsResolved(first, last);
+   schedulePrefetch();
+}
+
+// A failed prefetch is tried once more. If that fails, too, the visible
+// rows are resolved right away, so they aren't left as placeholders until
+// the viewport changes.
+void TsSqlBufferImpl::prefetchFailed()
+{
+   bool retry;
+   unsigned first, last;
+   {
+      QWriteLocker locker(&m_lock);
+      if (!m_prefetching)
+         return;
+      m_prefetchIndex.clear();
+      m_prefetching = false;
+      retry = !m_prefetchRetried;
+      m_prefetchRetried = retry;
+      first = m_viewFirst;
+      last  = m_viewLast;
+   }
+   if (retry)
+   {
+      schedulePrefetch();
+      return;
+   }
+   const unsigned count = this->count();
+   if (count == 0)
+      return;
+   last = std::min(last, count - 1);
+   if (first > last)
+      return;
+   for(unsigned row = first; row <= last; ++row)
+      resolve(row);
+   emit rowsResolved(first, last);
+}
+
+void TsSqlBufferImpl::setViewport(unsigned first, unsigned last)
+{
+   {
+      QWriteLocker locker(&m_lock);
+      m_viewFirst = first;
+      m_viewLast  = last;
    }
+   schedulePrefetch();
+}
+
+void TsSqlBufferImpl::setPrefetchMargin(unsigned rows)
+{
+   QWriteLocker locker(&m_lock);
+   m_margin = rows;
+}
+
+unsigned TsSqlBufferImpl::prefetchMargin() const
+{
+   QReadLocker locker(&m_lock);
+   return m_margin;
+}
+
+bool TsSqlBufferImpl::isResolved(unsigned row) const
+{
+   QReadLocker locker(&m_lock);
+   return row < count() && item(row).first;
 }
 
 void TsSqlBufferImpl::clear()
 {
-   QMutexLocker locker(&m_mutex);
-   m_rows.clear();
+   {
+      QWriteLocker locker(&m_lock);
+      freeChunks();
+      m_prefetchIndex.clear();
+   }
+   {
+      QMutexLocker locker(&m_cacheMutex);
+      m_blobCache.clear();
+   }
    emit cleared();
 }
 
-void TsSqlBufferImpl::appendEmptyRow(const TsSqlRow &row)
+// Appends a whole batch under one lock and announces it by one
+// rowsAppended(), besides the rowAppended() of each row. Readers see the
+// new rows once the count is published.
+void TsSqlBufferImpl::appendRows(const TsSqlRowBatch &rows, bool resolved)
 {
-   QMutexLocker locker(&m_mutex);
-   m_rows.push_back(qMakePair(false, row));
-   emit rowAppended();
+   if (rows.isEmpty())
+      return;
+   unsigned first;
+   {
+      QWriteLocker locker(&m_lock);
+      first = count();
+      unsigned row = first;
+      for(TsSqlRowBatch::const_iterator i = rows.begin();
+          i != rows.end();
+          ++i, ++row)
+      {
+         if (row / TsSqlBufferChunk::size == unsigned(m_chunks.size()))
+            m_chunks.append(new TsSqlBufferChunk);
+         item(row) = qMakePair(resolved, *i);
+      }
+      m_count.fetchAndStoreRelease(row);
+   }
+   for(int i = 0; i < rows.size(); ++i)
+      emit rowAppended();
+   emit rowsAppended(first, first + rows.size() - 1);
+}
+
+void TsSqlBufferImpl::appendEmptyRows(const TsSqlRowBatch &rows)
+{
+   appendRows(rows, false);
+}
+
+void TsSqlBufferImpl::appendRows(const TsSqlRowBatch &rows)
+{
+   appendRows(rows, true);
 }
 
 void TsSqlBufferImpl::appendRow(const TsSqlRow &row)
 {
-   QMutexLocker locker(&m_mutex);
-   m_rows.push_back(qMakePair(true, row));
-   emit rowAppended();
+   appendRows(TsSqlRowBatch() << row, true);
 }
 
+// The rows after index move down, the chunks stay allocated
 void TsSqlBufferImpl::deleteRow(unsigned index)
 {
-   QMutexLocker locker(&m_mutex);
-   m_rows.remove(index);
-   emit rowDeleted();
+   {
+      QWriteLocker locker(&m_lock);
+      if (index >= count())
+         return;
+      unsigned last = count() - 1;
+      for(unsigned i = index; i < last; ++i)
+         item(i) = item(i + 1);
+      item(last) = TsSqlBufferItem();
+      m_count.fetchAndStoreRelease(last);
+   }
+   emit rowDeleted(index);
 }
 
+// Rows outside of the buffer are empty
 void TsSqlBufferImpl::getRow(unsigned index, TsSqlRow &row)
 {
-   QMutexLocker locker(&m_mutex);
-   validateRow(index);
-   row = m_rows[index].second;
+   resolve(index);
+   {
+      QReadLocker locker(&m_lock);
+      row = index < count() ? item(index).second : TsSqlRow();
+   }
+   if (m_lazyBlobs)
+      for(TsSqlRow::iterator i = row.begin(); i != row.end(); ++i)
+         loadBlob(*i);
 }
 
 TsSqlRow TsSqlBufferImpl::getRow(unsigned index)
 {
-   QMutexLocker locker(&m_mutex);
-   validateRow(index);
-   return m_rows[index].second;
+   TsSqlRow result;
+   getRow(index, result);
+   return result;
+}
+
+// The value is read in place under the shared lock, it is empty for a
+// row outside of the buffer
+TsSqlVariant TsSqlBufferImpl::cell(unsigned row, unsigned column)
+{
+   resolve(row);
+   TsSqlVariant result;
+   {
+      QReadLocker locker(&m_lock);
+      if (row < count())
+         result = item(row).second.value(column);
+   }
+   loadBlob(result);
+   return result;
+}
+
+void TsSqlBufferImpl::withRow(unsigned row, TsSqlRowVisitor visitor, void *context)
+{
+   resolve(row);
+   TsSqlRow copy;
+   {
+      QReadLocker locker(&m_lock);
+      if (row >= count())
+         return;
+      if (!m_lazyBlobs)
+      {
+         visitor(item(row).second, context);
+         return;
+      }
+      // The row's blobs are loaded into a copy, as they are when it is got
+      copy = item(row).second;
+   }
+   for(TsSqlRow::iterator i = copy.begin(); i != copy.end(); ++i)
+      loadBlob(*i);
+   visitor(copy, context);
+}
+
+// Replaces a blob's id by it's content, which comes from the cache if
+// it was loaded before. A blob loaded by two threads at once is just
+// cached twice. If loading fails, the id is kept and nothing is cached,
+// so it is loaded again the next time.
+void TsSqlBufferImpl::loadBlob(TsSqlVariant &value)
+{
+   if (value.type() != stBlobId)
+      return;
+   TsSqlBlobId id = value.asBlobId();
+   quint64 key = (quint64(quint32(id.high)) << 32) | id.low;
+   {
+      QMutexLocker locker(&m_cacheMutex);
+      if (QString *cached = m_blobCache.object(key))
+      {
+         value.set(*cached);
+         return;
+      }
+   }
+   bool ok;
+   QByteArray data = m_data->loadBlobWaiting(id, &ok);
+   if (!ok)
+      return;
+   QString *content = new QString(QString::fromAscii(data.constData(), data.size()));
+   value.set(*content);
+   // Blobs larger than the whole cache are not kept
+   QMutexLocker locker(&m_cacheMutex);
+   m_blobCache.insert(key, content, data.size());
+}
+
+void TsSqlBufferImpl::setLazyBlobs(bool lazy, int cacheSize)
+{
+   {
+      QMutexLocker locker(&m_cacheMutex);
+      m_blobCache.setMaxCost(std::max(cacheSize, 0));
+   }
+   m_lazyBlobs = lazy;
+   if (m_data)
+      m_data->setFetchBlobIds(lazy);
+   if (m_batch)
+      m_batch->setFetchBlobIds(lazy);
+   if (m_prefetch)
+      m_prefetch->setFetchBlobIds(lazy);
+}
+
+bool TsSqlBufferImpl::lazyBlobs() const
+{
+   return m_lazyBlobs;
 }
 
 void TsSqlBufferImpl::setRow(unsigned index, const TsSqlRow &row)
 {
-   QMutexLocker locker(&m_mutex);
-   m_rows[index].first   = true; // don't overwrite the content with fetched data
-   m_rows[index].second  = row;
+   QWriteLocker locker(&m_lock);
+   if (index >= count())
+      return;
+   item(index).first   = true; // don't overwrite the content with fetched data
+   item(index).second  = row;
 }
 
 unsigned TsSqlBufferImpl::count() const
 {
-   QMutexLocker locker(&m_mutex);
-   return m_rows.count();
+   return m_count;
 }
 
 unsigned TsSqlBufferImpl::columnCount() const
@@ -152,217 +734,753 @@ TsSqlStatement *TsSqlBufferImpl::fetchStatement()
    return m_fetch;
 }
 
+void TsSqlBufferImpl::setBatchStatement(
+   TsSqlStatement *batchStatement,
+   int batchSize,
+   TsSqlStatement *prefetchStatement)
+{
+   if (m_prefetch)
+      disconnect(m_prefetch, 0, this, 0);
+   // A prefetch of the previous statement won't finish
+   {
+      QWriteLocker locker(&m_lock);
+      m_prefetchIndex.clear();
+      m_prefetching = false;
+      m_prefetchRetried = false;
+   }
+   // Only a prefetch but no batch statement is not allowed
+   if (!batchStatement)
+      prefetchStatement = 0;
+   m_batch = batchStatement;
+   m_prefetch = prefetchStatement;
+   m_batchSize = batchStatement ? std::max(batchSize, 0) : 0;
+   if (m_batch && m_lazyBlobs)
+      m_batch->setFetchBlobIds(true);
+   if (!m_prefetch)
+      return;
+   if (m_lazyBlobs)
+      m_prefetch->setFetchBlobIds(true);
+   // A prefetched batch arrives in one signal
+   m_prefetch->setFetchBatchSize(std::max(m_batchSize, 1));
+   connect(m_prefetch, SIGNAL(fetchedBatch(TsSqlRowBatch)), this, SLOT(prefetched(TsSqlRowBatch)));
+   connect(m_prefetch, SIGNAL(fetchFinished()),             this, SLOT(prefetchFinished()));
+   connect(m_prefetch, SIGNAL(error(QString)),              this, SLOT(prefetchFailed()));
+   schedulePrefetch();
+}
+
+TsSqlStatement *TsSqlBufferImpl::batchStatement()
+{
+   return m_batch;
+}
+
+TsSqlStatement *TsSqlBufferImpl::prefetchStatement()
+{
+   return m_prefetch;
+}
+
+int TsSqlBufferImpl::batchSize() const
+{
+   return m_batchSize;
+}
+
+TsSqlFetchQueue::TsSqlFetchQueue():
+   m_capacity(0)
+{
+}
+
+void TsSqlFetchQueue::reset(int capacity)
+{
+   // One slot always stays empty, to tell a full ring from an empty one.
+   m_rows.clear();
+   m_rows.resize(capacity > 0 ? capacity + 1 : 0);
+   m_capacity = std::max(capacity, 0);
+   m_head = 0;
+   m_tail = 0;
+   m_finished = 0;
+   m_producerWaiting = 0;
+   m_consumerNotified = 0;
+}
+
+int TsSqlFetchQueue::capacity() const
+{
+   return m_capacity;
+}
+
+int TsSqlFetchQueue::count() const
+{
+   int size = m_rows.size();
+   return size ? (m_tail - m_head + size) % size : 0;
+}
+
+bool TsSqlFetchQueue::isEmpty() const
+{
+   return m_head == m_tail;
+}
+
+bool TsSqlFetchQueue::isFull() const
+{
+   return count() >= m_capacity;
+}
+
+TsSqlRow &TsSqlFetchQueue::nextSlot()
+{
+   return m_rows[m_tail];
+}
+
+bool TsSqlFetchQueue::push()
+{
+   // The release makes the row visible before the new tail
+   m_tail.fetchAndStoreRelease((m_tail + 1) % m_rows.size());
+   return m_consumerNotified.testAndSetOrdered(0, 1);
+}
+
+bool TsSqlFetchQueue::waitForSpace()
+{
+   m_producerWaiting.fetchAndStoreOrdered(1);
+   // The consumer might have made room before it could see the flag
+   if (!isFull() && m_producerWaiting.testAndSetOrdered(1, 0))
+      return false;
+   return true;
+}
+
+void TsSqlFetchQueue::finish()
+{
+   m_finished.testAndSetRelease(0, 1);
+}
+
+bool TsSqlFetchQueue::pop(TsSqlRow &row)
+{
+   int head = m_head;
+   if (head == m_tail.fetchAndAddAcquire(0))
+      return false;
+   // TsSqlRow is implicitly shared, so this doesn't copy the values
+   row = m_rows[head];
+   m_rows[head] = TsSqlRow();
+   m_head.fetchAndStoreRelease((head + 1) % m_rows.size());
+   return true;
+}
+
+bool TsSqlFetchQueue::resumeProducer()
+{
+   return count() <= m_capacity / 2 &&
+      m_producerWaiting.testAndSetOrdered(1, 0);
+}
+
+void TsSqlFetchQueue::notified()
+{
+   m_consumerNotified.fetchAndStoreOrdered(0);
+}
+
+bool TsSqlFetchQueue::takeFinished()
+{
+   // Check the flag first, all rows have been pushed when it is set
+   return m_finished.fetchAndAddAcquire(0) == 1 &&
+      isEmpty() &&
+      m_finished.testAndSetOrdered(1, 2);
+}
 
-#define EMIT_ASYNC(object, signal) { TsSqlThreadEmitter emitter(object); emitter.signal(); }
-#define EMIT_ERROR(object, errorMessage) {TsSqlThreadEmitter emitter(object); emitter.emitError(errorMessage); }
+#define EMIT_ASYNC(object, signal) (object)->m_notifier.signal()
+#define EMIT_ERROR(object, errorMessage) (object)->m_notifier.emitError(errorMessage)
+#define EMIT_EXCEPTION(object, exception) emitException((object)->m_notifier, exception)
 
 #define DEBUG_RECEIVE(message) DEBUG_OUT(message)
 
 #define DBHANDLE(handle) (*reinterpret_cast<IBPP::Database*>   (handle))
 #define TRHANDLE(handle) (*reinterpret_cast<IBPP::Transaction*>(handle))
 #define STHANDLE(handle) (*reinterpret_cast<IBPP::Statement*>  (handle))
+#define BLHANDLE(handle) (*reinterpret_cast<IBPP::Blob*>       (handle))
 
-TsSqlThreadEmitter::TsSqlThreadEmitter(QObject *object):
-   m_object(object)
+// Firebird's isc_cancelled, the error of an operation interrupted by
+// fb_cancel_operation()
+static const int cancelledEngineCode = 335544794;
+
+static bool isCancelled(const std::exception &exception)
 {
+   const IBPP::SQLException *e = dynamic_cast<const IBPP::SQLException*>(&exception);
+   return e && e->EngineCode() == cancelledEngineCode;
 }
 
-void TsSqlThreadEmitter::emitDatabaseOpened()
+// Reports an operation interrupted by cancel() as cancelled, not as error
+static void emitException(TsSqlNotifier &notifier, const std::exception &exception)
 {
-   connect(this, SIGNAL(databaseOpened()), m_object, SIGNAL(opened()), Qt::QueuedConnection);
-   emit databaseOpened();
+   if (isCancelled(exception))
+      notifier.emitCancelled();
+   else
+      notifier.emitError(exception.what());
 }
 
-void TsSqlThreadEmitter::emitDatabaseClosed()
+TsSqlNotifier::TsSqlNotifier(QObject *object):
+   m_object(object),
+   m_pushed(0),
+   m_taken(0)
 {
-   connect(this, SIGNAL(databaseClosed()), m_object, SIGNAL(closed()), Qt::QueuedConnection);
-   emit databaseClosed();
 }
 
-void TsSqlThreadEmitter::emitTransactionStarted()
+TsSqlNotifier::~TsSqlNotifier()
 {
-   connect(this, SIGNAL(transactionStarted()), m_object, SIGNAL(started()), Qt::QueuedConnection);
-   emit transactionStarted();
+   while (TsSqlNotification *notification = take())
+      delete notification;
 }
 
-void TsSqlThreadEmitter::emitTransactionCommited()
+QEvent::Type TsSqlNotifier::eventType()
 {
-   connect(this, SIGNAL(transactionCommited()), m_object, SIGNAL(commited()), Qt::QueuedConnection);
-   emit transactionCommited();
+   static QEvent::Type type = static_cast<QEvent::Type>(QEvent::registerEventType());
+   return type;
 }
 
-void TsSqlThreadEmitter::emitTransactionRolledBack()
+void TsSqlNotifier::push(TsSqlNotification *notification)
 {
-   connect(this, SIGNAL(transactionRolledBack()), m_object, SIGNAL(rolledBack()), Qt::QueuedConnection);
-   emit transactionRolledBack();
+   TsSqlNotification *head;
+   do
+   {
+      head = m_pushed;
+      notification->next = head;
+   } while (!m_pushed.testAndSetRelease(head, notification));
+   // If the list was not empty, an event is already on it's way.
+   if (!head)
+      QCoreApplication::postEvent(m_object, new QEvent(eventType()));
 }
 
-void TsSqlThreadEmitter::emitStatementPrepared()
+void TsSqlNotifier::push(NotificationType type)
 {
-//   reinterpret_cast<TsSqlStatementImpl*>(m_object)->emitPrepared();
-   connect(this, SIGNAL(statementPrepared()), m_object, SLOT(emitPrepared()), Qt::QueuedConnection);
-   emit statementPrepared();
+   TsSqlNotification *notification = new TsSqlNotification;
+   notification->type         = type;
+   notification->atEnd        = false;
+   notification->affectedRows = 0;
+   notification->bytes        = 0;
+   notification->totalBytes   = 0;
+   push(notification);
 }
 
-void TsSqlThreadEmitter::emitStatementExecuted()
+TsSqlNotification *TsSqlNotifier::take()
 {
-   connect(this, SIGNAL(statementExecuted()), m_object, SIGNAL(executed()), Qt::QueuedConnection);
-   emit statementExecuted();
+   if (!m_taken)
+   {
+      // Take all pushed notifications at once and restore their order
+      TsSqlNotification *pushed = m_pushed.fetchAndStoreAcquire(0);
+      while (pushed)
+      {
+         TsSqlNotification *next = pushed->next;
+         pushed->next = m_taken;
+         m_taken = pushed;
+         pushed = next;
+      }
+   }
+   TsSqlNotification *result = m_taken;
+   if (result)
+      m_taken = result->next;
+   return result;
 }
 
-void TsSqlThreadEmitter::emitStatementFetchStarted()
+void TsSqlNotifier::emitCancelled()
 {
-   connect(this, SIGNAL(statementFetchStarted()), m_object, SIGNAL(fetchStarted()), Qt::QueuedConnection);
-   emit statementFetchStarted();
+   push(ntCancelled);
 }
 
-void TsSqlThreadEmitter::emitStatementFetched(const TsSqlRow &row)
+void TsSqlNotifier::emitDatabaseOpened()
 {
-   connect(this, SIGNAL(statementFetched(TsSqlRow)), m_object, SLOT(fetchDataset(TsSqlRow)), Qt::QueuedConnection);
-   emit statementFetched(row);
+   push(ntDatabaseOpened);
 }
 
-void TsSqlThreadEmitter::emitStatementFetchFinished()
+void TsSqlNotifier::emitDatabaseClosed()
 {
-   connect(this, SIGNAL(statementFetchFinished()), m_object, SIGNAL(fetchFinished()), Qt::QueuedConnection);
-   emit statementFetchFinished();
+   push(ntDatabaseClosed);
 }
 
-void TsSqlThreadEmitter::emitError(const QString &errorMessage)
+void TsSqlNotifier::emitTransactionStarted()
 {
-   connect(this, SIGNAL(error(QString)), m_object, SIGNAL(error(QString)), Qt::QueuedConnection);
-   emit error(errorMessage);
+   push(ntTransactionStarted);
 }
 
-TsSqlDatabaseThread::TsSqlDatabaseThread()
+void TsSqlNotifier::emitTransactionCommited()
 {
+   push(ntTransactionCommited);
 }
 
-void TsSqlDatabaseThread::run()
+void TsSqlNotifier::emitTransactionRolledBack()
 {
-   DEBUG_OUT("New thread " << this << " is running");
-   QThread::run();
-   DEBUG_OUT("Thread is stopping");
+   push(ntTransactionRolledBack);
 }
 
-void setFromStatement(TsSqlVariant &variant, void *statement, int col)
+void TsSqlNotifier::emitStatementPrepared()
 {
-   using namespace IBPP;
-   Statement &st = *reinterpret_cast<Statement*>(statement);
-   switch(st->ColumnType(col))
-   {
-      case sdBlob:
-         {
-            Blob b = BlobFactory(st->DatabasePtr(), st->TransactionPtr());
-            if (st->Get(col, b))
-               variant.setNull();
-            else
-            {
-               std::string temp;
-               b->Load(temp);
-               variant.setVariant(QVariant(QString::fromStdString(temp)));
-            }
-            break;
+   push(ntStatementPrepared);
+}
+
+void TsSqlNotifier::emitStatementExecuted()
+{
+   push(ntStatementExecuted);
+}
+
+void TsSqlNotifier::emitStatementBatchExecuted(
+   int affectedRows,
+   const TsSqlBatchErrors &errors)
+{
+   TsSqlNotification *notification = new TsSqlNotification;
+   notification->type         = ntStatementBatchExecuted;
+   notification->atEnd        = false;
+   notification->affectedRows = affectedRows;
+   notification->bytes        = 0;
+   notification->totalBytes   = 0;
+   notification->batchErrors  = errors;
+   push(notification);
+}
+
+void TsSqlNotifier::emitStatementFetchStarted()
+{
+   push(ntStatementFetchStarted);
+}
+
+void TsSqlNotifier::emitStatementFetched(const TsSqlRowBatch &rows, bool atEnd)
+{
+   TsSqlNotification *notification = new TsSqlNotification;
+   notification->type         = ntStatementFetched;
+   notification->rows         = rows;
+   notification->atEnd        = atEnd;
+   notification->affectedRows = 0;
+   notification->bytes        = 0;
+   notification->totalBytes   = 0;
+   push(notification);
+}
+
+void TsSqlNotifier::emitStatementRowsAvailable()
+{
+   push(ntStatementRowsAvailable);
+}
+
+void TsSqlNotifier::emitStatementFetchFinished()
+{
+   push(ntStatementFetchFinished);
+}
+
+void TsSqlNotifier::emitBlobTransferred(qint64 bytes, qint64 totalBytes, bool atEnd)
+{
+   TsSqlNotification *notification = new TsSqlNotification;
+   notification->type         = ntBlobTransferred;
+   notification->atEnd        = atEnd;
+   notification->affectedRows = 0;
+   notification->bytes        = bytes;
+   notification->totalBytes   = totalBytes;
+   push(notification);
+}
+
+void TsSqlNotifier::emitError(const QString &errorMessage)
+{
+   TsSqlNotification *notification = new TsSqlNotification;
+   notification->type         = ntError;
+   notification->atEnd        = false;
+   notification->affectedRows = 0;
+   notification->bytes        = 0;
+   notification->totalBytes   = 0;
+   notification->errorMessage = errorMessage;
+   push(notification);
+}
+
+TsSqlWorkerPool::TsSqlWorkerPool():
+   m_maximumThreads(qMax(1, QThread::idealThreadCount()))
+{
+}
+
+TsSqlWorkerPool::~TsSqlWorkerPool()
+{
+   for(int i = 0; i < m_threads.size(); ++i)
+   {
+      m_threads[i]->quit();
+      m_threads[i]->wait();
+      delete m_threads[i];
+   }
+}
+
+Q_GLOBAL_STATIC(TsSqlWorkerPool, workerPool)
+
+TsSqlWorkerPool *TsSqlWorkerPool::instance()
+{
+   return workerPool();
+}
+
+void TsSqlWorkerPool::setMaximumThreads(int count)
+{
+   QMutexLocker locker(&m_mutex);
+   m_maximumThreads = qMax(1, count);
+}
+
+int TsSqlWorkerPool::maximumThreads()
+{
+   QMutexLocker locker(&m_mutex);
+   return m_maximumThreads;
+}
+
+// Returns the thread with the least workers among those not running a
+// request, other than except. Another thread is started rather than
+// sharing one, while allowed. -1 if all threads are busy.
+// The caller holds m_mutex.
+int TsSqlWorkerPool::freeThread(int except)
+{
+   int best = -1;
+   for(int i = 0; i < m_threads.size(); ++i)
+      if (i != except && !m_threads[i]->running &&
+          (best < 0 || m_threads[i]->workers < m_threads[best]->workers))
+         best = i;
+   if ((best < 0 || m_threads[best]->workers > 0) && m_threads.size() < m_maximumThreads)
+   {
+      best = m_threads.size();
+      m_threads.append(new TsSqlWorkerThread());
+      m_threads[best]->start();
+      DEBUG_OUT("Started worker-thread " << best);
+   }
+   return best;
+}
+
+void TsSqlWorkerPool::assign(QObject *worker)
+{
+   QMutexLocker locker(&m_mutex);
+   int best = freeThread(-1);
+   // All threads are busy, it waits on the one with the least workers
+   if (best < 0)
+      for(int i = 0; i < m_threads.size(); ++i)
+         if (best < 0 || m_threads[i]->workers < m_threads[best]->workers)
+            best = i;
+   ++m_threads[best]->workers;
+   m_assigned.append(worker);
+   worker->moveToThread(m_threads[best]);
+}
+
+void TsSqlWorkerPool::release(QObject *worker)
+{
+   QMutexLocker locker(&m_mutex);
+   m_assigned.removeAll(worker);
+   TsSqlWorkerThread *thread = dynamic_cast<TsSqlWorkerThread*>(worker->thread());
+   if (thread)
+      --thread->workers;
+}
+
+// Runs on the worker's thread, which all it's neighbours live on, too, so
+// they may be moved from here. They are idle while this thread runs.
+// Only a slow worker takes the pool's mutex, the others just mark their
+// thread as running.
+void TsSqlWorkerPool::beginRequest(QObject *worker, bool slow)
+{
+   TsSqlWorkerThread *thread = dynamic_cast<TsSqlWorkerThread*>(worker->thread());
+   if (!thread)
+      return;
+   thread->running.fetchAndStoreRelease(1);
+   if (!slow)
+      return;
+   QMutexLocker locker(&m_mutex);
+   int index = m_threads.indexOf(thread);
+   for(int i = 0; thread->workers > 1 && i < m_assigned.size(); ++i)
+   {
+      QObject *other = m_assigned.at(i);
+      if (other == worker || other->thread() != thread)
+         continue;
+      int target = freeThread(index);
+      if (target < 0)
+         break;
+      other->moveToThread(m_threads[target]);
+      --thread->workers;
+      ++m_threads[target]->workers;
+   }
+}
+
+void TsSqlWorkerPool::endRequest(QObject *worker)
+{
+   TsSqlWorkerThread *thread = dynamic_cast<TsSqlWorkerThread*>(worker->thread());
+   if (thread)
+      thread->running.fetchAndStoreRelease(0);
+}
+
+TsSqlDatabaseWorker::TsSqlDatabaseWorker():
+   m_statementCacheSize(defaultStatementCacheSize),
+   m_statementCacheHits(0),
+   m_statementCacheMisses(0),
+   m_lastRequestMsecs(0)
+{
+}
+
+// Each request arrives as a queued slot call, the pool is told when it
+// runs (see TsSqlWorkerPool). A request is expected to take about as long
+// as the one before.
+bool TsSqlDatabaseWorker::event(QEvent *event)
+{
+   if (event->type() != QEvent::MetaCall)
+      return QObject::event(event);
+   TsSqlWorkerPool *pool = TsSqlWorkerPool::instance();
+   pool->beginRequest(this, m_lastRequestMsecs > TsSqlWorkerPool::slowRequestMsecs);
+   QTime timer;
+   timer.start();
+   bool result = QObject::event(event);
+   m_lastRequestMsecs = timer.elapsed();
+   pool->endRequest(this);
+   return result;
+}
+
+// Copies a value out of the row buffer, which may not be aligned for T
+template<typename T>
+inline T viewValue(const IBPP::ValueView &view, int offset = 0)
+{
+   T result;
+   memcpy(&result, view.data + offset, sizeof(T));
+   return result;
+}
+
+// Reads up to maxSize bytes of an opened blob, in segments as large as
+// Firebird allows.
+int readBlob(IBPP::Blob &blob, char *data, int maxSize)
+{
+   int result = 0;
+   while (result < maxSize)
+   {
+      int bytes = blob->Read(data + result, std::min(maxSize - result, 64 * 1024 - 1));
+      if (bytes == 0)
+         break;
+      result += bytes;
+   }
+   return result;
+}
+
+// Reads a whole blob into a buffer allocated at the blob's size, once
+QByteArray loadBlob(IBPP::Blob &blob)
+{
+   blob->Open();
+   int size = 0;
+   blob->Info(&size, 0, 0);
+   QByteArray result;
+   result.resize(size);
+   result.resize(readBlob(blob, result.data(), size));
+   blob->Close();
+   return result;
+}
+
+// Appends size bytes to a created blob, in segments as large as
+// Firebird allows.
+void writeBlob(IBPP::Blob &blob, const char *data, int size)
+{
+   for(int pos = 0; pos < size; pos += 64 * 1024 - 1)
+      blob->Write(data + pos, std::min(size - pos, 64 * 1024 - 1));
+}
+
+IBPP::ValueView blobIdView(const TsSqlBlobId &id)
+{
+   IBPP::ValueView view;
+   view.type   = IBPP::sdBlob;
+   view.data   = reinterpret_cast<const char*>(&id);
+   view.length = sizeof(id);
+   return view;
+}
+
+void setFromStatement(TsSqlVariant &variant, void *statement, int col, bool blobIds)
+{
+   using namespace IBPP;
+   Statement &st = *reinterpret_cast<Statement*>(statement);
+   ValueView view;
+   if (st->Get(col, view))
+   {
+      variant.setNull();
+      return;
+   }
+   switch(view.type)
+   {
+      case sdBlob:
+         if (blobIds)
+            variant.set(viewValue<TsSqlBlobId>(view));
+         else
+         {
+            Blob b = BlobFactory(st->DatabasePtr(), st->TransactionPtr());
+            b->SetId(view);
+            QByteArray data = loadBlob(b);
+            variant.set(QString::fromAscii(data.constData(), data.size()));
          }
+         break;
       case sdDate:
+         variant.setDateTime(stDate, viewValue<int>(view), 0);
+         break;
+      case sdTime:
+         variant.setDateTime(stTime, 0, viewValue<unsigned>(view));
+         break;
+      case sdTimestamp:
+         variant.setDateTime(
+            stTimeStamp,
+            viewValue<int>(view),
+            viewValue<unsigned>(view, sizeof(int)));
+         break;
+      case sdString:
+         variant.set(QString::fromAscii(view.data, view.length));
+         break;
+      case sdSmallint:
+         variant.set(viewValue<TsSqlSmallInt>(view));
+         break;
+      case sdInteger:
+         variant.set(viewValue<TsSqlInt>(view));
+         break;
+      case sdLargeint:
+         variant.set(viewValue<TsSqlLargeInt>(view));
+         break;
+      case sdFloat:
+         variant.set(viewValue<float>(view));
+         break;
+      case sdDouble:
          {
-            Date d;
-            if (st->Get(col, d))
-               variant.setNull();
-            else
-            {
-               int year, month, day;
-               d.GetDate(year, month, day);
-               variant.setVariant(QVariant(QDate(year, month, day)));
-            }
+            // Dialect 1 NUMERICs need IBPP's rounding
+            double temp = viewValue<double>(view);
+            if (view.scale != 0)
+               st->Get(col, temp);
+            variant.set(temp);
             break;
          }
-      case sdTime:
+      case sdArray:
          {
-            Time d;
-            if (st->Get(col, d))
-               variant.setNull();
-            else
+            // Described once per prepare, only the id changes per row
+            Array array = st->ColumnArray(col);
+            switch(array->ElementType())
             {
-               int hour, minute, second, msec;
-               d.GetTime(hour, minute, second, msec);
-               variant.setVariant(QVariant(QTime(hour, minute, second, msec)));
+               case sdSmallint:
+               case sdInteger:
+               case sdLargeint:
+               case sdFloat:
+               case sdDouble:
+                  break;
+               default:
+                  variant.setNull();
+                  return;
             }
-            break;
-         }
-      case sdTimestamp:
-         {
-            Timestamp d;
-            if (st->Get(col, d))
-               variant.setNull();
-            else
+            st->Get(col, array);
+            int count = 1;
+            for(int i = 0; i < array->Dimensions(); ++i)
             {
-               int year, month, day, hour, minute, second, msec;
-               d.GetTime(hour, minute, second, msec);
-               d.GetDate(year, month, day);
-               variant.setVariant(
-                  QVariant(QDateTime(
-                     QDate(year, month, day),
-                     QTime(hour, minute, second, msec))));
+               int low, high;
+               array->Bounds(i, &low, &high);
+               count *= high - low + 1;
             }
+            // DOUBLE PRECISION arrays are read straight into the vector,
+            // the other element types are converted by IBPP
+            QVector<double> values(count);
+            array->ReadTo(adDouble, values.data(), count);
+            variant.set(values);
             break;
          }
-      case sdString:
-         {
-            std::string temp;
-            if (st->Get(col, temp))
-               variant.setNull();
-            else
-               variant.setVariant(QVariant(QString::fromStdString(temp)));
+      default:
+         variant.setNull();
+         break;
+   }
+}
+
+TsSqlType ibppTypeToTs(IBPP::SDT ibppType);
+static void appendColumns(TsSqlColumnarBufferImpl &data, IBPP::Statement &st, int row);
+
+void appendFromStatement(TsSqlColumnarBuffer &buffer, void *statement)
+{
+   using namespace IBPP;
+   Statement &st = *reinterpret_cast<Statement*>(statement);
+   TsSqlColumnarBufferImpl &data = *buffer.m_impl;
+   int columns = st->Columns();
+   bool sameColumns = data.m_columns.size() == columns;
+   for(int i = 0; sameColumns && i < columns; ++i)
+      sameColumns = data.m_columns[i].type == ibppTypeToTs(st->ColumnType(i + 1));
+   if (!sameColumns)
+   {
+      // Rows of another statement are never mixed into the buffer
+      if (data.m_rowCount > 0)
+         throw std::invalid_argument("The buffer holds the columns of another statement.");
+      QVector<QString> names(columns);
+      QVector<TsSqlType> types(columns);
+      for(int i = 0; i < columns; ++i)
+      {
+         names[i] = QString::fromAscii(st->ColumnAlias(i + 1));
+         types[i] = ibppTypeToTs(st->ColumnType(i + 1));
+      }
+      data.setColumns(names, types);
+   }
+
+   // The row is counted when all of it's columns are appended, a failing
+   // column (e.g. a blob read) takes back the values of the others.
+   int row = data.m_rowCount;
+   try
+   {
+      appendColumns(data, st, row);
+   } catch(...)
+   {
+      data.truncate(row);
+      throw;
+   }
+   data.m_rowCount = row + 1;
+}
+
+static void appendColumns(TsSqlColumnarBufferImpl &data, IBPP::Statement &st, int row)
+{
+   using namespace IBPP;
+   int columns = data.m_columns.size();
+   for(int i = 0; i < columns; ++i)
+   {
+      TsSqlColumnData &column = data.m_columns[i];
+      if (row % 32 == 0)
+         column.nulls.append(0);
+      ValueView view;
+      bool isNull = st->Get(i + 1, view);
+      if (isNull)
+         data.setNull(i, row);
+      switch(column.type)
+      {
+         case stBlob:
+            {
+               QByteArray bytes;
+               if (!isNull)
+               {
+                  Blob b = BlobFactory(st->DatabasePtr(), st->TransactionPtr());
+                  b->SetId(view);
+                  bytes = loadBlob(b);
+               }
+               data.appendString(i, bytes.constData(), bytes.size());
+               break;
+            }
+         case stString:
+            data.appendString(i, view.data, view.length);
             break;
-         }
-      case sdSmallint:
-         {
-            TsSqlSmallInt temp;
-            if (st->Get(col, temp))
-               variant.setNull();
-            else
-               variant.setVariant(QVariant(temp));
+         case stDate:
+            {
+               TsSqlTimeStampData value = {isNull ? 0 : viewValue<int>(view), 0};
+               data.appendValue(i, value);
+               break;
+            }
+         case stTime:
+            {
+               TsSqlTimeStampData value = {0, isNull ? 0 : viewValue<unsigned>(view)};
+               data.appendValue(i, value);
+               break;
+            }
+         case stTimeStamp:
+            {
+               TsSqlTimeStampData value = {0, 0};
+               if (!isNull)
+               {
+                  value.date = viewValue<int>(view);
+                  value.time = viewValue<unsigned>(view, sizeof(int));
+               }
+               data.appendValue(i, value);
+               break;
+            }
+         case stSmallInt:
+            data.appendValue(i, isNull ? TsSqlSmallInt(0) : viewValue<TsSqlSmallInt>(view));
             break;
-         }
-      case sdInteger:
-         {
-            TsSqlInt temp;
-            if (st->Get(col, temp))
-               variant.setNull();
-            else
-               variant.setVariant(QVariant(temp));
+         case stInt:
+            data.appendValue(i, isNull ? TsSqlInt(0) : viewValue<TsSqlInt>(view));
             break;
-         }
-      case sdLargeint:
-         {
-            TsSqlLargeInt temp;
-            if (st->Get(col, temp))
-               variant.setNull();
-            else
-               variant.setVariant(QVariant(temp));
+         case stLargeInt:
+            data.appendValue(i, isNull ? TsSqlLargeInt(0) : viewValue<TsSqlLargeInt>(view));
             break;
-         }
-      case sdFloat:
-         {
-            float temp;
-            if (st->Get(col, temp))
-               variant.setNull();
-            else
-               variant.setVariant(QVariant(temp));
+         case stFloat:
+            data.appendValue(i, isNull ? 0.0f : viewValue<float>(view));
             break;
-         }
-      case sdDouble:
-         {
-            double temp;
-            if (st->Get(col, temp))
-               variant.setNull();
-            else
-               variant.setVariant(QVariant(temp));
+         case stDouble:
+            {
+               double value = isNull ? 0.0 : viewValue<double>(view);
+               if (!isNull && view.scale != 0)
+                  st->Get(i + 1, value);
+               data.appendValue(i, value);
+               break;
+            }
+         default:
             break;
-         }
-      default:
-         variant.setNull();
+      }
    }
 }
 
@@ -374,43 +1492,48 @@ void setStatementParam(const TsSqlVariant &variant, void *statement, int column)
       case stBlob:
          {
             IBPP::Blob blob = IBPP::BlobFactory(st->DatabasePtr(), st->TransactionPtr());
-            QByteArray &arr = *reinterpret_cast<QByteArray*>(variant.m_data.asPointer);
-            blob->Save(std::string(arr.constData(), arr.size()));
+            const QByteArray &arr = variant.sharedData();
+            blob->Create();
+            writeBlob(blob, arr.constData(), arr.size());
+            blob->Close();
             st->Set(column, blob);
          }
          break;
       case stDate:
-         {
-            QDate &d = *reinterpret_cast<QDate*>(variant.m_data.asPointer);
-            IBPP::Date date(d.year(), d.month(), d.day());
-            st->Set(column, date);
-         }
-         break;
       case stTime:
-         {
-            QTime &t = *reinterpret_cast<QTime*>(variant.m_data.asPointer);
-            IBPP::Time time(t.hour(), t.minute(), t.second(), t.msec());
-            st->Set(column, time);
-         }
-         break;
       case stTimeStamp:
          {
-            QDateTime &dt = *reinterpret_cast<QDateTime*>(variant.m_data.asPointer);
-            IBPP::Timestamp timestamp(
-               dt.date().year(),
-               dt.date().month(),
-               dt.date().day(),
-               dt.time().hour(),
-               dt.time().minute(),
-               dt.time().second(),
-               dt.time().msec());
-            st->Set(column, timestamp);
+            // Already in Firebird's encoding, so copied without conversion
+            const TsSqlTimeStampData &timeStamp = variant.m_data.asTimeStamp;
+            IBPP::ValueView view;
+            if (variant.m_type == stDate)
+            {
+               view.type   = IBPP::sdDate;
+               view.data   = reinterpret_cast<const char*>(&timeStamp.date);
+               view.length = sizeof(timeStamp.date);
+            } else if (variant.m_type == stTime)
+            {
+               view.type   = IBPP::sdTime;
+               view.data   = reinterpret_cast<const char*>(&timeStamp.time);
+               view.length = sizeof(timeStamp.time);
+            } else
+            {
+               view.type   = IBPP::sdTimestamp;
+               view.data   = reinterpret_cast<const char*>(&timeStamp);
+               view.length = sizeof(timeStamp);
+            }
+            st->Set(column, view);
          }
          break;
       case stString:
-         st->Set(
-            column,
-            reinterpret_cast<QString*>(variant.m_data.asPointer)->toStdString());
+         {
+            QByteArray bytes = variant.sharedString().toAscii();
+            IBPP::ValueView view;
+            view.type   = IBPP::sdString;
+            view.data   = bytes.constData();
+            view.length = bytes.size();
+            st->Set(column, view);
+         }
          break;
       case stSmallInt:
          st->Set(column, variant.m_data.asInt16);
@@ -427,12 +1550,18 @@ void setStatementParam(const TsSqlVariant &variant, void *statement, int column)
       case stDouble:
          st->Set(column, variant.m_data.asDouble);
          break;
+      case stBlobId:
+         st->Set(column, blobIdView(variant.m_data.asBlobId));
+         break;
+      case stArray:
+         // Writing needs the array's table and column, which parameters lack
+         throw std::invalid_argument("Array parameters are not supported.");
    default:
       st->SetNull(column);
    }
 }
 
-void TsSqlDatabaseThread::test()
+void TsSqlDatabaseWorker::test()
 {
    IBPP::Database db = IBPP::DatabaseFactory(
       "",
@@ -454,13 +1583,13 @@ void TsSqlDatabaseThread::test()
       for(int i = 1; i <= cols; ++i)
       {
          TsSqlVariant variant;
-         setFromStatement(variant, &st, i);
+         setFromStatement(variant, &st, i, false);
          qDebug() << variant.asString();
       }
    }
 }
 
-void TsSqlDatabaseThread::createDatabase(
+void TsSqlDatabaseWorker::createDatabase(
    TsSqlDatabaseImpl *object,
    const QString &server,
    const QString &database,
@@ -487,44 +1616,46 @@ void TsSqlDatabaseThread::createDatabase(
    DEBUG_OUT("Database-handle " << handle << " created for object " << object);
 }
 
-void TsSqlDatabaseThread::destroyDatabase(DatabaseHandle handle)
+void TsSqlDatabaseWorker::destroyDatabase(DatabaseHandle handle)
 {
+   clearStatementCache();
    std::vector<DatabaseHandle>::iterator i = std::find(
       m_databaseHandles.begin(),
       m_databaseHandles.end(),
       handle);
    if (i != m_databaseHandles.end() )
       m_databaseHandles.erase(i);
+   delete reinterpret_cast<IBPP::Database*>(handle);
 }
 
-void TsSqlDatabaseThread::databaseOpen(TsSqlDatabaseImpl *object, DatabaseHandle handle)
+void TsSqlDatabaseWorker::databaseOpen(TsSqlDatabaseImpl *object, DatabaseHandle handle)
 {
    DEBUG_RECEIVE("Received open request from " << object << " for database " << handle);
    try
    {
       DBHANDLE(handle)->Connect();
-      TsSqlThreadEmitter emitter(object);
       EMIT_ASYNC(object, emitDatabaseOpened);
    } catch(std::exception &e)
    {
-      EMIT_ERROR(object, e.what());
+      EMIT_EXCEPTION(object, e);
    }
 }
 
-void TsSqlDatabaseThread::databaseClose(TsSqlDatabaseImpl *object, DatabaseHandle handle)
+void TsSqlDatabaseWorker::databaseClose(TsSqlDatabaseImpl *object, DatabaseHandle handle)
 {
    DEBUG_RECEIVE("Received close request from " << object << " for database " << handle);
    try
    {
+      clearStatementCache();
       DBHANDLE(handle)->Disconnect();
       EMIT_ASYNC(object, emitDatabaseClosed);
    } catch(std::exception &e)
    {
-      EMIT_ERROR(object, e.what())
+      EMIT_EXCEPTION(object, e);
    }
 }
 
-void TsSqlDatabaseThread::databaseIsOpen(
+void TsSqlDatabaseWorker::databaseIsOpen(
    TsSqlDatabaseImpl *object, 
    DatabaseHandle handle, 
    bool *result)
@@ -535,11 +1666,30 @@ void TsSqlDatabaseThread::databaseIsOpen(
       *result = DBHANDLE(handle)->Connected();
    } catch(std::exception &e)
    {
-      EMIT_ERROR(object, e.what())
+      EMIT_EXCEPTION(object, e);
+   }
+}
+
+void TsSqlDatabaseWorker::databasePing(
+   TsSqlDatabaseImpl *object,
+   DatabaseHandle handle,
+   bool *result)
+{
+   DEBUG_RECEIVE("Received ping request from " << object << " for database " << handle);
+   // A broken attachment is an expected answer here, hence no error is emitted
+   try
+   {
+      *result = DBHANDLE(handle)->Connected();
+      if (*result)
+         DBHANDLE(handle)->Info(0, 0, 0, 0, 0, 0, 0, 0);
+   } catch(std::exception &e)
+   {
+      DEBUG_OUT("Ping failed: " << e.what());
+      *result = false;
    }
 }
 
-void TsSqlDatabaseThread::databaseInfo(
+void TsSqlDatabaseWorker::databaseInfo(
    TsSqlDatabaseImpl *object, 
    DatabaseHandle handle, 
    DatabaseInfo info,
@@ -576,11 +1726,11 @@ void TsSqlDatabaseThread::databaseInfo(
       }
    } catch(std::exception &e)
    {
-      EMIT_ERROR(object, e.what());
+      EMIT_EXCEPTION(object, e);
    }
 }
 
-void TsSqlDatabaseThread::databaseConnectedUsers(
+void TsSqlDatabaseWorker::databaseConnectedUsers(
    TsSqlDatabaseImpl *object,
    DatabaseHandle handle,
    QVector<QString> *result)
@@ -597,11 +1747,11 @@ void TsSqlDatabaseThread::databaseConnectedUsers(
          result->push_back(QString::fromStdString(*i));
    } catch(std::exception  &e)
    {
-      EMIT_ERROR(object, e.what());
+      EMIT_EXCEPTION(object, e);
    }
 }
 
-void TsSqlDatabaseThread::createTransaction(
+void TsSqlDatabaseWorker::createTransaction(
    TsSqlTransactionImpl *object,
    DatabaseHandle database, 
    TsSqlTransaction::TransactionMode mode)
@@ -632,17 +1782,26 @@ void TsSqlDatabaseThread::createTransaction(
    }
 }
 
-void TsSqlDatabaseThread::destroyTransaction(TransactionHandle handle)
+void TsSqlDatabaseWorker::destroyTransaction(TransactionHandle handle)
 {
+   // Cached statements would keep the transaction alive
+   void *transaction = TRHANDLE(handle).intf();
+   for(int i = m_statementCache.size() - 1; i >= 0; --i)
+      if (m_statementCache[i].transaction == transaction)
+      {
+         delete reinterpret_cast<IBPP::Statement*>(m_statementCache[i].statement);
+         m_statementCache.removeAt(i);
+      }
    std::vector<TransactionHandle>::iterator i = std::find(
       m_transactionHandles.begin(),
       m_transactionHandles.end(),
       handle);
    if (i != m_transactionHandles.end())
       m_transactionHandles.erase(i);
+   delete reinterpret_cast<IBPP::Transaction*>(handle);
 }
 
-void TsSqlDatabaseThread::transactionStart(
+void TsSqlDatabaseWorker::transactionStart(
    TsSqlTransactionImpl *object,
    TransactionHandle handle)
 {
@@ -657,7 +1816,7 @@ void TsSqlDatabaseThread::transactionStart(
    }
 }
 
-void TsSqlDatabaseThread::transactionCommit(
+void TsSqlDatabaseWorker::transactionCommit(
    TsSqlTransactionImpl *object,
    TransactionHandle handle)
 {
@@ -672,7 +1831,7 @@ void TsSqlDatabaseThread::transactionCommit(
    }
 }
 
-void TsSqlDatabaseThread::transactionCommitRetaining(
+void TsSqlDatabaseWorker::transactionCommitRetaining(
    TsSqlTransactionImpl *object,
    TransactionHandle handle)
 {
@@ -688,7 +1847,7 @@ void TsSqlDatabaseThread::transactionCommitRetaining(
    }
 }
 
-void TsSqlDatabaseThread::transactionRollBack(
+void TsSqlDatabaseWorker::transactionRollBack(
    TsSqlTransactionImpl *object,
    TransactionHandle handle)
 {
@@ -703,7 +1862,7 @@ void TsSqlDatabaseThread::transactionRollBack(
    }
 }
 
-void TsSqlDatabaseThread::createStatement(
+void TsSqlDatabaseWorker::createStatement(
    TsSqlStatementImpl *object,
    DatabaseHandle database, 
    TransactionHandle transaction)
@@ -725,7 +1884,7 @@ void TsSqlDatabaseThread::createStatement(
    }
 }
 
-void TsSqlDatabaseThread::createStatement(
+void TsSqlDatabaseWorker::createStatement(
    TsSqlStatementImpl *object,
    DatabaseHandle database, 
    TransactionHandle transaction,
@@ -742,6 +1901,7 @@ void TsSqlDatabaseThread::createStatement(
                      TRHANDLE(transaction),
                      sql.toStdString())));
       object->m_handle = handle;
+      describeStatement(object, handle);
    } catch(std::exception &e)
    {
       object->m_handle = 0;     
@@ -749,17 +1909,19 @@ void TsSqlDatabaseThread::createStatement(
    }
 }
 
-void TsSqlDatabaseThread::destroyStatement(StatementHandle handle)
+void TsSqlDatabaseWorker::destroyStatement(StatementHandle handle)
 {
+   cacheStatement(handle);
    std::vector<StatementHandle>::iterator i = std::find(
       m_statementHandles.begin(),
       m_statementHandles.end(),
       handle);
    if (i != m_statementHandles.end())
       m_statementHandles.erase(i);
+   delete reinterpret_cast<IBPP::Statement*>(handle);
 }
 
-void TsSqlDatabaseThread::statementPrepare(
+void TsSqlDatabaseWorker::statementPrepare(
    TsSqlStatementImpl *object,
    StatementHandle handle,
    const QString  &sql)
@@ -768,15 +1930,16 @@ void TsSqlDatabaseThread::statementPrepare(
    try
    {
       DEBUG_LOG("Preparing " << sql);
-      STHANDLE(handle)->Prepare(sql.toStdString());
+      prepareStatement(handle, sql);
+      describeStatement(object, handle);
       EMIT_ASYNC(object, emitStatementPrepared);
    } catch(std::exception &e)
    {
-      EMIT_ERROR(object, e.what());
+      EMIT_EXCEPTION(object, e);
    }
 }
 
-void TsSqlDatabaseThread::statementExecute(
+void TsSqlDatabaseWorker::statementExecute(
    TsSqlStatementImpl *object,
    StatementHandle handle,
    bool startFetch)
@@ -785,17 +1948,18 @@ void TsSqlDatabaseThread::statementExecute(
    try
    {
       DEBUG_LOG("Executing " << STHANDLE(handle)->Sql().c_str());
-      STHANDLE(handle)->Execute();
+      setBoundParams(object, handle);
+      executeStatement(handle);
       EMIT_ASYNC(object, emitStatementExecuted);
       if (startFetch)
          statementStartFetch(object, handle);
    } catch(std::exception &e)
    {
-      EMIT_ERROR(object, e.what());
+      EMIT_EXCEPTION(object, e);
    }
 }
 
-void TsSqlDatabaseThread::statementExecute(
+void TsSqlDatabaseWorker::statementExecute(
    TsSqlStatementImpl *object,
    StatementHandle handle,
    const QString &sql,
@@ -805,18 +1969,20 @@ void TsSqlDatabaseThread::statementExecute(
    try
    {
       DEBUG_LOG("Executing " << sql);
-      STHANDLE(handle)->Execute(sql.toStdString());
+      prepareStatement(handle, sql);
+      describeStatement(object, handle);
       EMIT_ASYNC(object, emitStatementPrepared);
+      executeStatement(handle);
       EMIT_ASYNC(object, emitStatementExecuted);
       if (startFetch)
          statementStartFetch(object, handle);
    } catch(std::exception &e)
    {
-      EMIT_ERROR(object, e.what());
+      EMIT_EXCEPTION(object, e);
    }
 }
 
-void TsSqlDatabaseThread::statementExecute(
+void TsSqlDatabaseWorker::statementExecute(
    TsSqlStatementImpl *object,
    StatementHandle handle,
    const TsSqlRow &params,
@@ -827,17 +1993,17 @@ void TsSqlDatabaseThread::statementExecute(
    {
       DEBUG_LOG("Executing " << STHANDLE(handle)->Sql().c_str() << " with params");
       setParams(handle, params);
-      STHANDLE(handle)->Execute();
+      executeStatement(handle);
       EMIT_ASYNC(object, emitStatementExecuted);
       if (startFetch)
          statementStartFetch(object, handle);
    } catch(std::exception &e)
    {
-      EMIT_ERROR(object, e.what());
+      EMIT_EXCEPTION(object, e);
    }
 }
 
-void TsSqlDatabaseThread::statementExecute(
+void TsSqlDatabaseWorker::statementExecute(
    TsSqlStatementImpl *object,
    StatementHandle handle,
    const QString &sql,
@@ -848,54 +2014,229 @@ void TsSqlDatabaseThread::statementExecute(
    try
    {
       DEBUG_LOG("Preparing " << sql);
-      STHANDLE(handle)->Prepare(sql.toStdString());
+      prepareStatement(handle, sql);
+      describeStatement(object, handle);
       EMIT_ASYNC(object, emitStatementPrepared);
       setParams(handle, params);
       DEBUG_LOG("Executing " << sql << " with params");
-      STHANDLE(handle)->Execute();
+      executeStatement(handle);
       EMIT_ASYNC(object, emitStatementExecuted);
       if (startFetch)
          statementStartFetch(object, handle);
    } catch(std::exception &e)
    {
-      EMIT_ERROR(object, e.what());
+      EMIT_EXCEPTION(object, e);
    }
 }
 
-void TsSqlDatabaseThread::statementSetParam(
-   StatementHandle handle,
-   int col,
-   const TsSqlVariant &param)
+int TsSqlDatabaseWorker::executeBatch(
+   StatementHandle statement,
+   const TsSqlRowBatch &params,
+   TsSqlBatchErrors &errors)
 {
-   setStatementParam(param, handle, col);
+   // The parameters of all rows are set into the same input-row of the
+   // statement, which is prepared only once.
+   int affectedRows = 0;
+   for(int row = 0; row < params.size(); ++row)
+   {
+      try
+      {
+         setParams(statement, params[row]);
+         executeStatement(statement);
+         affectedRows += STHANDLE(statement)->AffectedRows();
+      } catch(std::exception &e)
+      {
+         errors.append(TsSqlBatchError(row, e.what()));
+         // Don't go on with the remaining rows after cancel()
+         if (isCancelled(e))
+            break;
+      }
+   }
+   return affectedRows;
 }
 
-void TsSqlDatabaseThread::emitStatementRow(
-   TsSqlStatementImpl *receiver, 
-   StatementHandle statement)
+void TsSqlDatabaseWorker::statementExecuteBatch(
+   TsSqlStatementImpl *object,
+   StatementHandle handle,
+   const TsSqlRowBatch &params)
 {
-   TsSqlRow row;
-   readRow(statement, row);
-   TsSqlThreadEmitter emitter(receiver);
-   emitter.emitStatementFetched(row);
+   DEBUG_RECEIVE("Received batch execute request from " << object << " for statement " << handle);
+   TsSqlBatchErrors errors;
+   int affectedRows = executeBatch(handle, params, errors);
+   object->m_notifier.emitStatementBatchExecuted(affectedRows, errors);
 }
 
-void TsSqlDatabaseThread::readRow(StatementHandle statement, TsSqlRow &row)
+void TsSqlDatabaseWorker::statementExecuteBatch(
+   TsSqlStatementImpl *object,
+   StatementHandle handle,
+   const TsSqlRowBatch &params,
+   int *affectedRows,
+   TsSqlBatchErrors *errors)
 {
-   using namespace IBPP;
-   Statement &st = STHANDLE(statement);
-   int columns = st->Columns();
-   row.resize(columns);
-   for(int i = 1; i <= columns; ++i)
-      setFromStatement(row[i-1], statement, i);
+   DEBUG_RECEIVE("Received batch execute request from " << object << " for statement " << handle);
+   *affectedRows = executeBatch(handle, params, *errors);
+   object->m_notifier.emitStatementBatchExecuted(*affectedRows, *errors);
 }
 
-void TsSqlDatabaseThread::setParams(StatementHandle statement, const TsSqlRow &params)
+void TsSqlDatabaseWorker::setBoundParams(
+   TsSqlStatementImpl *object,
+   StatementHandle statement)
 {
-   int col = 1;
-   for(TsSqlRow::const_iterator i = params.begin();
-       i != params.end();
-       ++i)
+   QMutexLocker locker(&object->m_bindingMutex);
+   IBPP::Statement &st = STHANDLE(statement);
+   for(int i = 0; i < object->m_bindings.size(); ++i)
+   {
+      const TsSqlParamBinding &binding = object->m_bindings[i];
+      if (!binding.value)
+         continue;
+      IBPP::ValueView view;
+      const char *data = static_cast<const char*>(binding.value);
+      switch(binding.type)
+      {
+         case stString:
+            {
+               const QByteArray *bytes = static_cast<const QByteArray*>(binding.value);
+               view.type   = IBPP::sdString;
+               data        = bytes->constData();
+               view.length = bytes->size();
+            }
+            break;
+         case stSmallInt:
+            view.type   = IBPP::sdSmallint;
+            view.length = sizeof(TsSqlSmallInt);
+            break;
+         case stInt:
+            view.type   = IBPP::sdInteger;
+            view.length = sizeof(TsSqlInt);
+            break;
+         case stLargeInt:
+            view.type   = IBPP::sdLargeint;
+            view.length = sizeof(TsSqlLargeInt);
+            break;
+         case stFloat:
+            view.type   = IBPP::sdFloat;
+            view.length = sizeof(float);
+            break;
+         case stDouble:
+            view.type   = IBPP::sdDouble;
+            view.length = sizeof(double);
+            break;
+         default:
+            {
+               // Dates and times are passed as their part of the timestamp
+               const TsSqlTimeStampData *timeStamp = 
+                  static_cast<const TsSqlTimeStampData*>(binding.value);
+               view.type = st->ParameterType(i + 1);
+               if (view.type == IBPP::sdDate)
+               {
+                  data        = reinterpret_cast<const char*>(&timeStamp->date);
+                  view.length = sizeof(timeStamp->date);
+               } else if (view.type == IBPP::sdTime)
+               {
+                  data        = reinterpret_cast<const char*>(&timeStamp->time);
+                  view.length = sizeof(timeStamp->time);
+               } else
+               {
+                  view.type   = IBPP::sdTimestamp;
+                  view.length = sizeof(TsSqlTimeStampData);
+               }
+            }
+      }
+      if (!binding.isNull || !*binding.isNull)
+         view.data = data;
+      st->Set(i + 1, view);
+   }
+}
+
+void TsSqlDatabaseWorker::statementSetParam(
+   StatementHandle handle,
+   int col,
+   const TsSqlVariant &param)
+{
+   setStatementParam(param, handle, col);
+}
+
+void TsSqlDatabaseWorker::emitStatementRows(
+   TsSqlStatementImpl *receiver, 
+   StatementHandle statement)
+{
+   // The first row has already been fetched by the caller.
+   // Collect more rows until either the batch is full, the time for
+   // this batch is up or there are no rows left.
+   receiver->m_fetchBatchMutex.lock();
+   int batchSize = receiver->m_fetchBatchSize;
+   int batchTime = receiver->m_fetchBatchTime;
+   receiver->m_fetchBatchMutex.unlock();
+
+   TsSqlRowBatch rows;
+   rows.reserve(batchSize);
+   QTime timer;
+   timer.start();
+   bool atEnd = false;
+   for (;;)
+   {
+      rows.resize(rows.size() + 1);
+      readRow(receiver, statement, rows.last());
+      if (rows.size() >= batchSize ||
+          (batchTime > 0 && timer.elapsed() >= batchTime))
+         break;
+      if (!STHANDLE(statement)->Fetch())
+      {
+         atEnd = true;
+         break;
+      }
+   }
+   receiver->m_notifier.emitStatementFetched(rows, atEnd);
+}
+
+void TsSqlDatabaseWorker::produceRows(
+   TsSqlStatementImpl *receiver,
+   StatementHandle statement)
+{
+   TsSqlFetchQueue &queue = receiver->m_fetchQueue;
+   for (;;)
+   {
+      receiver->m_stopFetchingMutex.lock();
+      bool stopFetching = receiver->m_stopFetching;
+      receiver->m_stopFetching = false;
+      receiver->m_stopFetchingMutex.unlock();
+
+      if (stopFetching || !STHANDLE(statement)->Fetch())
+      {
+         DEBUG_OUT("Finished fetching datasets for statement " << statement);
+         queue.finish();
+         EMIT_ASYNC(receiver, emitStatementRowsAvailable);
+         return;
+      }
+      readRow(receiver, statement, queue.nextSlot());
+      if (queue.push())
+         EMIT_ASYNC(receiver, emitStatementRowsAvailable);
+      // Pause until the consumer made room, it will emit statementFetchNext.
+      if (queue.isFull() && queue.waitForSpace())
+         return;
+   }
+}
+
+void TsSqlDatabaseWorker::readRow(
+   TsSqlStatementImpl *object,
+   StatementHandle statement,
+   TsSqlRow &row)
+{
+   using namespace IBPP;
+   Statement &st = STHANDLE(statement);
+   int columns = st->Columns();
+   bool blobIds = object->m_fetchBlobIds;
+   row.resize(columns);
+   for(int i = 1; i <= columns; ++i)
+      setFromStatement(row[i-1], statement, i, blobIds);
+}
+
+void TsSqlDatabaseWorker::setParams(StatementHandle statement, const TsSqlRow &params)
+{
+   int col = 1;
+   for(TsSqlRow::const_iterator i = params.begin();
+       i != params.end();
+       ++i)
    {
       statementSetParam(
          statement,
@@ -905,7 +2246,158 @@ void TsSqlDatabaseThread::setParams(StatementHandle statement, const TsSqlRow &p
    }
 }
 
-void TsSqlDatabaseThread::statementStartFetch(
+void TsSqlDatabaseWorker::describeStatement(
+   TsSqlStatementImpl *object,
+   StatementHandle statement)
+{
+   IBPP::Statement &st = STHANDLE(statement);
+   QVector<TsSqlColumnInfo> columns(st->Columns());
+   for(int i = 0; i < columns.size(); ++i)
+   {
+      TsSqlColumnInfo &column = columns[i];
+      column.name    = QString::fromAscii(st->ColumnName(i + 1));
+      column.alias   = QString::fromAscii(st->ColumnAlias(i + 1));
+      column.table   = QString::fromAscii(st->ColumnTable(i + 1));
+      column.type    = ibppTypeToTs(st->ColumnType(i + 1));
+      column.subType = st->ColumnSubtype(i + 1);
+      column.size    = st->ColumnSize(i + 1);
+      column.scale   = st->ColumnScale(i + 1);
+   }
+   QVector<TsSqlColumnInfo> params(st->Parameters());
+   for(int i = 0; i < params.size(); ++i)
+   {
+      TsSqlColumnInfo &param = params[i];
+      param.type    = ibppTypeToTs(st->ParameterType(i + 1));
+      param.subType = st->ParameterSubtype(i + 1);
+      param.size    = st->ParameterSize(i + 1);
+      param.scale   = st->ParameterScale(i + 1);
+   }
+   object->setDescription(columns, params);
+}
+
+// Collapses whitespace outside of literals and quoted identifiers, so
+// statements differing in their formatting, only, share a cache-entry.
+static QString normalizedSql(const QString &sql)
+{
+   QString result;
+   result.reserve(sql.size());
+   QChar quote;
+   bool space = false;
+   for(int i = 0; i < sql.size(); ++i)
+   {
+      QChar c = sql[i];
+      if (quote.isNull())
+      {
+         if (c.isSpace())
+         {
+            space = true;
+            continue;
+         }
+         if (space && !result.isEmpty())
+            result += QChar(' ');
+         space = false;
+         if (c == QChar('\'') || c == QChar('"'))
+            quote = c;
+      }
+      else if (c == quote)
+         quote = QChar();
+      result += c;
+   }
+   return result;
+}
+
+bool TsSqlDatabaseWorker::cacheStatement(StatementHandle statement)
+{
+   IBPP::Statement &st = STHANDLE(statement);
+   int size = m_statementCacheSize;
+   if (size <= 0 || st.intf() == 0 || st->Type() == IBPP::stUnknown)
+      return false;
+
+   TsSqlCachedStatement cached;
+   cached.sql = normalizedSql(QString::fromStdString(st->Sql()));
+   cached.transaction = st->TransactionPtr().intf();
+   cached.statement = reinterpret_cast<StatementHandle>(new IBPP::Statement(st));
+   for(int i = 0; i < m_statementCache.size(); ++i)
+      if (m_statementCache[i].transaction == cached.transaction &&
+          m_statementCache[i].sql == cached.sql)
+      {
+         delete reinterpret_cast<IBPP::Statement*>(m_statementCache[i].statement);
+         m_statementCache.removeAt(i);
+         break;
+      }
+   m_statementCache.append(cached);
+   while (m_statementCache.size() > size)
+      delete reinterpret_cast<IBPP::Statement*>(m_statementCache.takeFirst().statement);
+   return true;
+}
+
+void TsSqlDatabaseWorker::prepareStatement(StatementHandle statement, const QString &sql)
+{
+   IBPP::Statement &st = STHANDLE(statement);
+   if (m_statementCacheSize <= 0)
+   {
+      st->Prepare(sql.toStdString());
+      return;
+   }
+
+   QString normalized = normalizedSql(sql);
+   void *transaction = st->TransactionPtr().intf();
+   for(int i = m_statementCache.size() - 1; i >= 0; --i)
+   {
+      const TsSqlCachedStatement &cached = m_statementCache[i];
+      if (cached.transaction == transaction && cached.sql == normalized)
+      {
+         IBPP::Statement *hit = reinterpret_cast<IBPP::Statement*>(cached.statement);
+         m_statementCache.removeAt(i);
+         cacheStatement(statement);
+         st = *hit;
+         delete hit;
+         m_statementCacheHits.ref();
+         return;
+      }
+   }
+
+   m_statementCacheMisses.ref();
+   // The cache keeps the current statement, so a new one is needed
+   if (cacheStatement(statement))
+      st = IBPP::StatementFactory(st->DatabasePtr(), st->TransactionPtr());
+   st->Prepare(sql.toStdString());
+}
+
+void TsSqlDatabaseWorker::executeStatement(StatementHandle statement)
+{
+   STHANDLE(statement)->Execute();
+   // Changed metadata may render the prepared statements invalid
+   if (STHANDLE(statement)->Type() == IBPP::stDDL)
+      clearStatementCache();
+}
+
+void TsSqlDatabaseWorker::clearStatementCache()
+{
+   while (!m_statementCache.isEmpty())
+      delete reinterpret_cast<IBPP::Statement*>(m_statementCache.takeFirst().statement);
+}
+
+// The statements beyond the new size are closed right away, the least
+// recently used first
+void TsSqlDatabaseWorker::setStatementCacheSize(int size)
+{
+   m_statementCacheSize = size;
+   while (m_statementCache.size() > std::max(size, 0))
+      delete reinterpret_cast<IBPP::Statement*>(m_statementCache.takeFirst().statement);
+}
+
+int TsSqlDatabaseWorker::statementCacheHits() const
+{
+   return m_statementCacheHits;
+}
+
+int TsSqlDatabaseWorker::statementCacheMisses() const
+{
+   return m_statementCacheMisses;
+}
+
+void TsSqlDatabaseWorker::statementStartFetch(
    TsSqlStatementImpl *object,
    StatementHandle handle)
 {
@@ -919,6 +2411,11 @@ void TsSqlDatabaseThread::statementStartFetch(
          EMIT_ASYNC(object, emitStatementFetchStarted);
          EMIT_ASYNC(object, emitStatementFetchFinished);
       }
+      else if (object->m_fetchQueue.capacity() > 0)
+      {
+         EMIT_ASYNC(object, emitStatementFetchStarted);
+         produceRows(object, handle);
+      }
       else
       {
          bool atEnd = !STHANDLE(handle)->Fetch();
@@ -929,15 +2426,28 @@ void TsSqlDatabaseThread::statementStartFetch(
             EMIT_ASYNC(object, emitStatementFetchFinished);
          }
          else
-            emitStatementRow(object, handle);
+            emitStatementRows(object, handle);
       }
    } catch(std::exception &e)
    {
-      EMIT_ERROR(object, e.what());
+      EMIT_EXCEPTION(object, e);
    }
 }
 
-void TsSqlDatabaseThread::statementFetchNext(
+void TsSqlDatabaseWorker::statementStopFetch(
+   TsSqlStatementImpl *object,
+   StatementHandle handle)
+{
+   DEBUG_RECEIVE("Received stop fetch request from " << object << " for statement " << handle);
+
+   // Runs after the requests queued before, so the producer of a read-ahead
+   // fetch has returned: it finished, saw the stop or waits for room. The
+   // flag is cleared in case it wasn't seen, not to stop the next fetch.
+   QMutexLocker locker(&object->m_stopFetchingMutex);
+   object->m_stopFetching = false;
+}
+
+void TsSqlDatabaseWorker::statementFetchNext(
    TsSqlStatementImpl *object,
    StatementHandle handle)
 {
@@ -947,6 +2457,12 @@ void TsSqlDatabaseThread::statementFetchNext(
    // database connection is closed.
    try
    {
+      if (object->m_fetchQueue.capacity() > 0)
+      {
+         // The consumer made room in the read-ahead queue
+         produceRows(object, handle);
+         return;
+      }
       object->m_stopFetchingMutex.lock();
       bool stopFetching = object->m_stopFetching;
       if (stopFetching)
@@ -962,26 +2478,75 @@ void TsSqlDatabaseThread::statementFetchNext(
       else
       {
          if (STHANDLE(handle)->Fetch())
-            emitStatementRow(object, handle);
+            emitStatementRows(object, handle);
          else
             EMIT_ASYNC(object, emitStatementFetchFinished);
       }
    } catch(std::exception &e)
    {
-      EMIT_ERROR(object, e.what());
+      EMIT_EXCEPTION(object, e);
    }
 }
 
-void TsSqlDatabaseThread::statementFetchSingleRow(
+void TsSqlDatabaseWorker::statementFetchSingleRow(
+   TsSqlStatementImpl *object,
    StatementHandle handle,
    TsSqlRow *result)
 {
    if (STHANDLE(handle)->Fetch())
-      readRow(handle, *result);
+      readRow(object, handle, *result);
    else
       result->resize(0);
 }
 
+void TsSqlDatabaseWorker::statementFetchRows(
+   TsSqlStatementImpl *object,
+   StatementHandle handle,
+   TsSqlRowBatch *rows,
+   int maxRows,
+   int *result)
+{
+   *result = 0;
+   try
+   {
+      while((maxRows < 0 || *result < maxRows) && STHANDLE(handle)->Fetch())
+      {
+         rows->resize(rows->size() + 1);
+         readRow(object, handle, rows->last());
+         ++*result;
+      }
+   } catch(std::exception &e)
+   {
+      EMIT_EXCEPTION(object, e);
+   }
+}
+
+void TsSqlDatabaseWorker::statementFetchColumns(
+   TsSqlStatementImpl *object,
+   StatementHandle handle,
+   TsSqlColumnarBuffer *buffer,
+   int maxRows,
+   int *result)
+{
+   *result = 0;
+   try
+   {
+      // Checked before the first fetch, so no row is lost
+      IBPP::Statement &st = STHANDLE(handle);
+      for(int i = 1; i <= st->Columns(); ++i)
+         if (st->ColumnType(i) == IBPP::sdArray)
+            throw std::invalid_argument("Array columns are not supported by fetchColumns().");
+      while((maxRows < 0 || *result < maxRows) && st->Fetch())
+      {
+         appendFromStatement(*buffer, handle);
+         ++*result;
+      }
+   } catch(std::exception &e)
+   {
+      EMIT_EXCEPTION(object, e);
+   }
+}
+
 TsSqlType ibppTypeToTs(IBPP::SDT ibppType)
 {
    switch(ibppType)
@@ -1006,13 +2571,15 @@ TsSqlType ibppTypeToTs(IBPP::SDT ibppType)
          return stFloat;
       case IBPP::sdDouble:
          return stDouble;
+      case IBPP::sdArray:
+         return stArray;
       default:
          DEBUG_OUT("Unsupported column type detected, defaulting to string.");
          return stString;
    }
 }
 
-void TsSqlDatabaseThread::statementInfo(
+void TsSqlDatabaseWorker::statementInfo(
    TsSqlStatementImpl *object, 
    StatementHandle handle, 
    StatementInfo info,
@@ -1029,40 +2596,205 @@ void TsSqlDatabaseThread::statementInfo(
             STHANDLE(handle)->Plan(temp);
             *result = QString::fromStdString(temp);
             break;
-         case siColumnCount:
-            {
-               int iTemp = STHANDLE(handle)->Columns();
-               *result = iTemp;
-            }
-            break;
-         case siColumnName:
-            *result = QString::fromAscii(STHANDLE(handle)->ColumnName(param.toInt() + 1));
-            break;
-         case siColumnIndex:
-            *result = STHANDLE(handle)->ColumnNum(param.toString().toStdString());
-            break;
-         case siColumnAlias:
-            *result = QString::fromAscii(STHANDLE(handle)->ColumnAlias(param.toInt() -+1));
-            break;
-         case siColumnTable:
-            *result = QString::fromAscii(STHANDLE(handle)->ColumnTable(param.toInt() + 1));
-            break;
-         case siColumnType:
-            *result = static_cast<int>(ibppTypeToTs(STHANDLE(handle)->ColumnType(param.toInt() + 1)));
-            break;
-         case siColumnSubType:
-            *result = STHANDLE(handle)->ColumnSubtype(param.toInt() + 1);
-            break;
-         case siColumnSize:
-            *result = STHANDLE(handle)->ColumnSize(param.toInt() + 1);
-            break;
-         case siColumnScale:
-            *result = STHANDLE(handle)->ColumnScale(param.toInt() + 1);
-            break;
          default:
             DEBUG_OUT("Unknown statement info(" << info << ") requested!");
       }
    } catch(std::exception &e)
+   {
+      EMIT_EXCEPTION(object, e);
+   }
+}
+
+void TsSqlDatabaseWorker::statementLoadBlob(
+   TsSqlStatementImpl *object,
+   StatementHandle handle,
+   const TsSqlBlobId &id,
+   QByteArray *result,
+   bool *ok)
+{
+   *ok = false;
+   try
+   {
+      IBPP::Statement &st = STHANDLE(handle);
+      IBPP::Blob blob = IBPP::BlobFactory(st->DatabasePtr(), st->TransactionPtr());
+      blob->SetId(blobIdView(id));
+      *result = loadBlob(blob);
+      *ok = true;
+   } catch(std::exception &e)
+   {
+      EMIT_EXCEPTION(object, e);
+   }
+}
+
+void TsSqlDatabaseWorker::createBlob(
+   TsSqlBlobReaderImpl *object,
+   DatabaseHandle database,
+   TransactionHandle transaction,
+   const TsSqlBlobId &id)
+{
+   DEBUG_OUT("Creating blob-handle");
+   try
+   {
+      IBPP::Blob blob = IBPP::BlobFactory(DBHANDLE(database), TRHANDLE(transaction));
+      blob->SetId(blobIdView(id));
+      blob->Open();
+      blob->Info(&object->m_size, 0, 0);
+      BlobHandle handle = reinterpret_cast<BlobHandle>(new IBPP::Blob(blob));
+      m_blobHandles.push_back(handle);
+      object->m_handle = handle;
+   } catch(std::exception &e)
+   {
+      object->m_handle = 0;
+      EMIT_ERROR(object, e.what());
+   }
+}
+
+void TsSqlDatabaseWorker::destroyBlob(BlobHandle handle)
+{
+   std::vector<BlobHandle>::iterator i = std::find(
+      m_blobHandles.begin(),
+      m_blobHandles.end(),
+      handle);
+   if (i != m_blobHandles.end())
+      m_blobHandles.erase(i);
+   delete reinterpret_cast<IBPP::Blob*>(handle);
+}
+
+void TsSqlDatabaseWorker::blobRead(
+   TsSqlBlobReaderImpl *object,
+   BlobHandle handle,
+   char *data,
+   int maxSize,
+   int *result)
+{
+   *result = 0;
+   try
+   {
+      *result = readBlob(BLHANDLE(handle), data, maxSize);
+      object->m_position += *result;
+   } catch(std::exception &e)
+   {
+      EMIT_ERROR(object, e.what());
+   }
+}
+
+void TsSqlDatabaseWorker::blobReadAll(
+   TsSqlBlobReaderImpl *object,
+   BlobHandle handle,
+   QByteArray *result)
+{
+   // Info() reports the blob's total size, so the buffer never has to grow
+   int size = std::max(object->m_size - object->m_position, 0);
+   result->resize(size);
+   blobRead(object, handle, result->data(), size, &size);
+   result->resize(size);
+}
+
+void TsSqlDatabaseWorker::blobReadNext(
+   TsSqlBlobReaderImpl *object,
+   BlobHandle handle)
+{
+   DEBUG_RECEIVE("Received blob read request from " << object << " for blob " << handle);
+   try
+   {
+      QByteArray &buffer = object->m_buffer;
+      buffer.resize(object->m_chunkSize);
+      int bytes = readBlob(BLHANDLE(handle), buffer.data(), buffer.size());
+      if (bytes > 0 && object->m_device->write(buffer.constData(), bytes) != bytes)
+      {
+         EMIT_ERROR(object, object->m_device->errorString());
+         return;
+      }
+      object->m_position += bytes;
+      // The reader requests the next chunk, unless it is at the end
+      object->m_notifier.emitBlobTransferred(
+         object->m_position,
+         object->m_size,
+         bytes < buffer.size() || object->m_position >= object->m_size);
+   } catch(std::exception &e)
+   {
+      EMIT_ERROR(object, e.what());
+   }
+}
+
+void TsSqlDatabaseWorker::createBlob(
+   TsSqlBlobWriterImpl *object,
+   DatabaseHandle database,
+   TransactionHandle transaction)
+{
+   DEBUG_OUT("Creating blob-handle");
+   try
+   {
+      IBPP::Blob blob = IBPP::BlobFactory(DBHANDLE(database), TRHANDLE(transaction));
+      blob->Create();
+      BlobHandle handle = reinterpret_cast<BlobHandle>(new IBPP::Blob(blob));
+      m_blobHandles.push_back(handle);
+      object->m_handle = handle;
+   } catch(std::exception &e)
+   {
+      object->m_handle = 0;
+      EMIT_ERROR(object, e.what());
+   }
+}
+
+void TsSqlDatabaseWorker::blobWrite(
+   TsSqlBlobWriterImpl *object,
+   BlobHandle handle,
+   const char *data,
+   int size)
+{
+   try
+   {
+      writeBlob(BLHANDLE(handle), data, size);
+      object->m_size += size;
+   } catch(std::exception &e)
+   {
+      EMIT_ERROR(object, e.what());
+   }
+}
+
+void TsSqlDatabaseWorker::blobWriteNext(
+   TsSqlBlobWriterImpl *object,
+   BlobHandle handle)
+{
+   DEBUG_RECEIVE("Received blob write request from " << object << " for blob " << handle);
+   try
+   {
+      // Only one chunk is in memory at any time
+      QByteArray &buffer = object->m_buffer;
+      buffer.resize(object->m_chunkSize);
+      qint64 bytes = object->m_device->read(buffer.data(), buffer.size());
+      if (bytes < 0)
+      {
+         EMIT_ERROR(object, object->m_device->errorString());
+         return;
+      }
+      writeBlob(BLHANDLE(handle), buffer.constData(), bytes);
+      object->m_size += bytes;
+      // The writer requests the next chunk, unless it is at the end
+      object->m_notifier.emitBlobTransferred(
+         object->m_size,
+         object->m_deviceSize,
+         bytes < buffer.size() || object->m_device->atEnd());
+   } catch(std::exception &e)
+   {
+      EMIT_ERROR(object, e.what());
+   }
+}
+
+void TsSqlDatabaseWorker::blobClose(
+   TsSqlBlobWriterImpl *object,
+   BlobHandle handle,
+   TsSqlBlobId *result)
+{
+   try
+   {
+      IBPP::Blob &blob = BLHANDLE(handle);
+      blob->Close();
+      IBPP::ValueView id;
+      blob->GetId(id);
+      memcpy(result, id.data, sizeof(*result));
+   } catch(std::exception &e)
    {
       EMIT_ERROR(object, e.what());
    }
@@ -1076,12 +2808,14 @@ TsSqlDatabaseImpl::TsSqlDatabaseImpl(
    const QString &characterSet,
    const QString &role,
    const QString &createParams):
-   m_handle(0)
+   m_handle(0),
+   m_worker(new TsSqlDatabaseWorker()),
+   m_notifier(this),
+   m_statementCacheSize(TsSqlDatabaseWorker::defaultStatementCacheSize)
 {
-   m_thread.moveToThread(&m_thread);
-   m_thread.start();
+   TsSqlWorkerPool::instance()->assign(m_worker);
    DEBUG_OUT("New database object " << this);
-   connect(this, SIGNAL(runTest()), &m_thread, SLOT(test()), Qt::QueuedConnection);
+   connect(this, SIGNAL(runTest()), m_worker, SLOT(test()), Qt::QueuedConnection);
    connect(
       this, 
       SIGNAL(createHandle(
@@ -1093,7 +2827,7 @@ TsSqlDatabaseImpl::TsSqlDatabaseImpl(
             QString,
             QString,
             QString)),
-      &m_thread,
+      m_worker,
       SLOT(createDatabase(
             TsSqlDatabaseImpl *,
             QString,
@@ -1107,9 +2841,15 @@ TsSqlDatabaseImpl::TsSqlDatabaseImpl(
    connect(
       this,
       SIGNAL(destroyHandle(DatabaseHandle)),
-      &m_thread,
+      m_worker,
       SLOT(destroyDatabase(DatabaseHandle)),
       Qt::BlockingQueuedConnection);
+   connect(
+      this,
+      SIGNAL(databaseSetStatementCacheSize(int)),
+      m_worker,
+      SLOT(setStatementCacheSize(int)),
+      Qt::QueuedConnection);
 
    emit createHandle(
          this,
@@ -1126,25 +2866,25 @@ TsSqlDatabaseImpl::TsSqlDatabaseImpl(
    connect(
       this,
       SIGNAL(databaseOpen(TsSqlDatabaseImpl*, DatabaseHandle)),
-      &m_thread,
+      m_worker,
       SLOT(databaseOpen(TsSqlDatabaseImpl*, DatabaseHandle)),
       Qt::QueuedConnection);
    connect(
       this,
       SIGNAL(databaseClose(TsSqlDatabaseImpl*, DatabaseHandle)),
-      &m_thread,
+      m_worker,
       SLOT(databaseClose(TsSqlDatabaseImpl*, DatabaseHandle)),
       Qt::QueuedConnection);
    connect(
       this,
       SIGNAL(databaseOpenWaiting(TsSqlDatabaseImpl*, DatabaseHandle)),
-      &m_thread,
+      m_worker,
       SLOT(databaseOpen(TsSqlDatabaseImpl*, DatabaseHandle)),
       Qt::BlockingQueuedConnection);
    connect(
       this,
       SIGNAL(databaseCloseWaiting(TsSqlDatabaseImpl*, DatabaseHandle)),
-      &m_thread,
+      m_worker,
       SLOT(databaseClose(TsSqlDatabaseImpl*, DatabaseHandle)),
       Qt::BlockingQueuedConnection);
    connect(
@@ -1153,12 +2893,24 @@ TsSqlDatabaseImpl::TsSqlDatabaseImpl(
          TsSqlDatabaseImpl*, 
          DatabaseHandle, 
          bool*)),
-      &m_thread,
+      m_worker,
       SLOT(databaseIsOpen(
          TsSqlDatabaseImpl*, 
          DatabaseHandle, 
          bool*)),
       Qt::BlockingQueuedConnection);
+   connect(
+      this,
+      SIGNAL(databasePing(
+         TsSqlDatabaseImpl*,
+         DatabaseHandle,
+         bool*)),
+      m_worker,
+      SLOT(databasePing(
+         TsSqlDatabaseImpl*,
+         DatabaseHandle,
+         bool*)),
+      Qt::BlockingQueuedConnection);
    connect(
       this,
       SIGNAL(databaseInfo(
@@ -1166,7 +2918,7 @@ TsSqlDatabaseImpl::TsSqlDatabaseImpl(
          DatabaseHandle, 
          DatabaseInfo,
          QString *)),
-      &m_thread,
+      m_worker,
       SLOT(databaseInfo(
          TsSqlDatabaseImpl *, 
          DatabaseHandle, 
@@ -1179,7 +2931,7 @@ TsSqlDatabaseImpl::TsSqlDatabaseImpl(
          TsSqlDatabaseImpl*,
          DatabaseHandle,
          QVector<QString>*)),
-      &m_thread,
+      m_worker,
       SLOT(databaseConnectedUsers(
          TsSqlDatabaseImpl*,
          DatabaseHandle,
@@ -1187,6 +2939,33 @@ TsSqlDatabaseImpl::TsSqlDatabaseImpl(
       Qt::BlockingQueuedConnection);
 }
 
+void TsSqlDatabaseImpl::customEvent(QEvent *event)
+{
+   if (event->type() != TsSqlNotifier::eventType())
+      return QObject::customEvent(event);
+   while (TsSqlNotification *notification = m_notifier.take())
+   {
+      switch(notification->type)
+      {
+         case ntDatabaseOpened:
+            emit opened();
+            break;
+         case ntDatabaseClosed:
+            emit closed();
+            break;
+         case ntCancelled:
+            emit cancelled();
+            break;
+         case ntError:
+            emit error(notification->errorMessage);
+            break;
+         default:
+            DEBUG_OUT("Unexpected notification " << notification->type << " for database " << this);
+      }
+      delete notification;
+   }
+}
+
 void TsSqlDatabaseImpl::test()
 {
    emit runTest();
@@ -1219,6 +2998,40 @@ bool TsSqlDatabaseImpl::isOpen()
    return result;
 }
 
+void TsSqlDatabaseImpl::setStatementCacheSize(int size)
+{
+   m_statementCacheSize = size;
+   emit databaseSetStatementCacheSize(size);
+}
+
+int TsSqlDatabaseImpl::statementCacheSize()
+{
+   return m_statementCacheSize;
+}
+
+int TsSqlDatabaseImpl::statementCacheHits()
+{
+   return m_worker->statementCacheHits();
+}
+
+int TsSqlDatabaseImpl::statementCacheMisses()
+{
+   return m_worker->statementCacheMisses();
+}
+
+bool TsSqlDatabaseImpl::ping()
+{
+   bool result = false;
+   emit databasePing(this, m_handle, &result);
+   return result;
+}
+
+bool TsSqlDatabaseImpl::cancel()
+{
+   // Called directly, the database-thread is busy with what is cancelled
+   return m_handle && DBHANDLE(m_handle)->Cancel();
+}
+
 QString TsSqlDatabaseImpl::server()
 {
    QString result;
@@ -1277,23 +3090,296 @@ QVector<QString> TsSqlDatabaseImpl::connectedUsers()
 
 TsSqlDatabaseImpl::~TsSqlDatabaseImpl()
 {
+   // Don't wait for a runaway query before the handle is destroyed
+   cancel();
+   // This is a blocking call, so all requests sent before are done, too.
    emit destroyHandle(m_handle);
-   m_thread.quit();
-   // Wait for the thread to gracefully finish.
-   // If this doesn't happen withing 10 seconds, try to terminate it
-   if (!m_thread.wait(10000))
+   TsSqlWorkerPool::instance()->release(m_worker);
+   // The worker may still have requests of it's own queued
+   m_worker->deleteLater();
+}
+
+TsSqlConnectionPoolImpl::TsSqlConnectionPoolImpl(
+   int minimumSize,
+   int maximumSize,
+   int idleTimeout,
+   int validationInterval):
+   m_minimumSize(minimumSize),
+   m_maximumSize(maximumSize),
+   m_idleTimeout(idleTimeout),
+   m_validationInterval(validationInterval)
+{
+   memset(&m_statistics, 0, sizeof(m_statistics));
+}
+
+TsSqlConnectionPoolImpl::~TsSqlConnectionPoolImpl()
+{
+   QList<TsSqlDatabase*> idle;
+   for(QHash<QString, TsSqlConnectionPoolEntry>::iterator i = m_entries.begin();
+       i != m_entries.end();
+       ++i)
+   {
+      while (!i.value().idle.isEmpty())
+         idle.append(i.value().idle.takeFirst().database);
+   }
+   if (!m_leases.isEmpty())
+      DEBUG_OUT("Connection pool destroyed with " << m_leases.size() << " leased databases");
+   destroy(idle);
+}
+
+// Idle databases have no thread affinity, so any thread can take them over.
+// The implementation object receives the notifications, so it moves, too.
+void TsSqlConnectionPoolImpl::attach(TsSqlDatabase *database)
+{
+   database->m_impl->moveToThread(QThread::currentThread());
+   database->moveToThread(QThread::currentThread());
+}
+
+void TsSqlConnectionPoolImpl::detach(TsSqlDatabase *database)
+{
+   database->m_impl->moveToThread(0);
+   database->moveToThread(0);
+}
+
+void TsSqlConnectionPoolImpl::destroy(const QList<TsSqlDatabase*> &databases)
+{
+   for(int i = 0; i < databases.size(); ++i)
    {
-      m_thread.terminate();
-      // After it was tried to terminate it, wait another
-      // 10 seconds for the thread to finish.
-      m_thread.wait(10000);
+      attach(databases[i]);
+      delete databases[i];
    }
 }
 
+void TsSqlConnectionPoolImpl::takeExpired(QList<TsSqlDatabase*> &expired)
+{
+   QHash<QString, TsSqlConnectionPoolEntry>::iterator i = m_entries.begin();
+   while (i != m_entries.end())
+   {
+      TsSqlConnectionPoolEntry &entry = i.value();
+      while (!entry.idle.isEmpty() &&
+             entry.idle.size() + entry.leased > m_minimumSize &&
+             entry.idle.first().idleSince.elapsed() > m_idleTimeout)
+         expired.append(entry.idle.takeFirst().database);
+      if (entry.idle.isEmpty() && entry.leased == 0)
+         i = m_entries.erase(i);
+      else
+         ++i;
+   }
+}
+
+void TsSqlConnectionPoolImpl::endLease(TsSqlDatabase *database)
+{
+   QMutexLocker locker(&m_mutex);
+   --m_entries[m_leases.take(database)].leased;
+   // The waiters of all keys share m_released, wake them all
+   m_released.wakeAll();
+}
+
+TsSqlDatabase *TsSqlConnectionPoolImpl::acquire(
+   const QString &server,
+   const QString &database,
+   const QString &user,
+   const QString &password,
+   const QString &characterSet,
+   const QString &role,
+   int timeout)
+{
+   const QChar separator(0x1f);
+   QString key =
+      server       + separator +
+      database     + separator +
+      user         + separator +
+      password     + separator +
+      characterSet + separator +
+      role;
+   QList<TsSqlDatabase*> expired;
+   TsSqlPooledDatabase pooled = {0, QTime()};
+   {
+      QMutexLocker locker(&m_mutex);
+      takeExpired(expired);
+      QTime waitTime;
+      bool waited = false;
+      for(;;)
+      {
+         TsSqlConnectionPoolEntry &entry = m_entries[key];
+         if (!entry.idle.isEmpty())
+         {
+            pooled = entry.idle.takeLast();
+            ++m_statistics.hits;
+            break;
+         }
+         if (entry.leased < m_maximumSize)
+         {
+            ++m_statistics.misses;
+            break;
+         }
+         if (!waited)
+         {
+            waitTime.start();
+            waited = true;
+            ++m_statistics.waits;
+         }
+         int remaining = timeout - waitTime.elapsed();
+         if (timeout >= 0 && remaining <= 0)
+         {
+            ++m_statistics.timeouts;
+            m_statistics.waitTime += waitTime.elapsed();
+            locker.unlock();
+            destroy(expired);
+            return 0;
+         }
+         m_released.wait(&m_mutex, timeout < 0 ? ULONG_MAX : remaining);
+      }
+      if (waited)
+         m_statistics.waitTime += waitTime.elapsed();
+      // The lease starts now, so opening a new database counts, too
+      ++m_entries[key].leased;
+      if (pooled.database)
+         m_leases.insert(pooled.database, key);
+   }
+   destroy(expired);
+
+   if (pooled.database)
+   {
+      attach(pooled.database);
+      if (pooled.idleSince.elapsed() <= m_validationInterval || pooled.database->ping())
+         return pooled.database;
+      DEBUG_OUT("Dropping pooled database " << pooled.database << ", it failed to respond");
+      // Keep the lease and replace the database
+      QMutexLocker locker(&m_mutex);
+      m_leases.remove(pooled.database);
+      locker.unlock();
+      delete pooled.database;
+   }
+
+   TsSqlDatabase *result = new TsSqlDatabase(
+      server,
+      database,
+      user,
+      password,
+      characterSet,
+      role);
+   result->openWaiting();
+   QMutexLocker locker(&m_mutex);
+   m_leases.insert(result, key);
+   locker.unlock();
+   if (result->isOpen())
+      return result;
+   endLease(result);
+   delete result;
+   return 0;
+}
+
+void TsSqlConnectionPoolImpl::release(TsSqlDatabase *database)
+{
+   QMutexLocker locker(&m_mutex);
+   if (!m_leases.contains(database))
+   {
+      DEBUG_OUT("Database " << database << " was not acquired from this pool");
+      return;
+   }
+   locker.unlock();
+
+   if (!database->isOpen())
+   {
+      endLease(database);
+      delete database;
+      return;
+   }
+
+   detach(database);
+   QList<TsSqlDatabase*> expired;
+   locker.relock();
+   TsSqlConnectionPoolEntry &entry = m_entries[m_leases.take(database)];
+   --entry.leased;
+   TsSqlPooledDatabase pooled = {database, QTime()};
+   pooled.idleSince.start();
+   entry.idle.append(pooled);
+   takeExpired(expired);
+   m_released.wakeAll();
+   locker.unlock();
+   destroy(expired);
+}
+
+void TsSqlConnectionPoolImpl::expire()
+{
+   QList<TsSqlDatabase*> expired;
+   QMutexLocker locker(&m_mutex);
+   takeExpired(expired);
+   locker.unlock();
+   destroy(expired);
+}
+
+TsSqlConnectionPool::Statistics TsSqlConnectionPoolImpl::statistics()
+{
+   QMutexLocker locker(&m_mutex);
+   TsSqlConnectionPool::Statistics result = m_statistics;
+   result.idle = 0;
+   result.leased = 0;
+   for(QHash<QString, TsSqlConnectionPoolEntry>::const_iterator i = m_entries.constBegin();
+       i != m_entries.constEnd();
+       ++i)
+   {
+      result.idle += i.value().idle.size();
+      result.leased += i.value().leased;
+   }
+   return result;
+}
+
+void TsSqlConnectionPoolImpl::setMinimumSize(int size)
+{
+   QMutexLocker locker(&m_mutex);
+   m_minimumSize = size;
+}
+
+void TsSqlConnectionPoolImpl::setMaximumSize(int size)
+{
+   QMutexLocker locker(&m_mutex);
+   m_maximumSize = size;
+   m_released.wakeAll();
+}
+
+void TsSqlConnectionPoolImpl::setIdleTimeout(int msecs)
+{
+   QMutexLocker locker(&m_mutex);
+   m_idleTimeout = msecs;
+}
+
+void TsSqlConnectionPoolImpl::setValidationInterval(int msecs)
+{
+   QMutexLocker locker(&m_mutex);
+   m_validationInterval = msecs;
+}
+
+int TsSqlConnectionPoolImpl::minimumSize()
+{
+   QMutexLocker locker(&m_mutex);
+   return m_minimumSize;
+}
+
+int TsSqlConnectionPoolImpl::maximumSize()
+{
+   QMutexLocker locker(&m_mutex);
+   return m_maximumSize;
+}
+
+int TsSqlConnectionPoolImpl::idleTimeout()
+{
+   QMutexLocker locker(&m_mutex);
+   return m_idleTimeout;
+}
+
+int TsSqlConnectionPoolImpl::validationInterval()
+{
+   QMutexLocker locker(&m_mutex);
+   return m_validationInterval;
+}
+
 TsSqlTransactionImpl::TsSqlTransactionImpl(
    TsSqlDatabaseImpl &database, 
    TsSqlTransaction::TransactionMode mode):
-   m_handle(0)
+   m_handle(0),
+   m_notifier(this)
 {
    DEBUG_OUT("Creating new transaction");
    connect(
@@ -1302,7 +3388,7 @@ TsSqlTransactionImpl::TsSqlTransactionImpl(
          TsSqlTransactionImpl *,
          DatabaseHandle,
          TsSqlTransaction::TransactionMode)),
-      &database.m_thread,
+      database.m_worker,
       SLOT(createTransaction(
          TsSqlTransactionImpl *,
          DatabaseHandle,
@@ -1311,7 +3397,7 @@ TsSqlTransactionImpl::TsSqlTransactionImpl(
    connect(
       this,
       SIGNAL(destroyTransaction(TransactionHandle)),
-      &database.m_thread,
+      database.m_worker,
       SLOT(destroyTransaction(TransactionHandle)),
       Qt::BlockingQueuedConnection);
 
@@ -1327,7 +3413,7 @@ TsSqlTransactionImpl::TsSqlTransactionImpl(
       SIGNAL(transactionStart(
          TsSqlTransactionImpl *,
          TransactionHandle)),
-      &database.m_thread,
+      database.m_worker,
       SLOT(transactionStart(
          TsSqlTransactionImpl *,
          TransactionHandle)),
@@ -1337,7 +3423,7 @@ TsSqlTransactionImpl::TsSqlTransactionImpl(
       SIGNAL(transactionCommit(
          TsSqlTransactionImpl *,
          TransactionHandle)),
-      &database.m_thread,
+      database.m_worker,
       SLOT(transactionCommit(
          TsSqlTransactionImpl *,
          TransactionHandle)),
@@ -1347,7 +3433,7 @@ TsSqlTransactionImpl::TsSqlTransactionImpl(
       SIGNAL(transactionCommitRetaining(
          TsSqlTransactionImpl *,
          TransactionHandle)),
-      &database.m_thread,
+      database.m_worker,
       SLOT(transactionCommitRetaining(
          TsSqlTransactionImpl *,
          TransactionHandle)),
@@ -1357,7 +3443,7 @@ TsSqlTransactionImpl::TsSqlTransactionImpl(
       SIGNAL(transactionRollBack(
          TsSqlTransactionImpl *,
          TransactionHandle)),
-      &database.m_thread,
+      database.m_worker,
       SLOT(transactionRollBack(
          TsSqlTransactionImpl *,
          TransactionHandle)),
@@ -1369,7 +3455,7 @@ TsSqlTransactionImpl::TsSqlTransactionImpl(
       SIGNAL(transactionStartWaiting(
          TsSqlTransactionImpl *,
          TransactionHandle)),
-      &database.m_thread,
+      database.m_worker,
       SLOT(transactionStart(
          TsSqlTransactionImpl *,
          TransactionHandle)),
@@ -1379,7 +3465,7 @@ TsSqlTransactionImpl::TsSqlTransactionImpl(
       SIGNAL(transactionCommitWaiting(
          TsSqlTransactionImpl *,
          TransactionHandle)),
-      &database.m_thread,
+      database.m_worker,
       SLOT(transactionCommit(
          TsSqlTransactionImpl *,
          TransactionHandle)),
@@ -1389,7 +3475,7 @@ TsSqlTransactionImpl::TsSqlTransactionImpl(
       SIGNAL(transactionCommitRetainingWaiting(
          TsSqlTransactionImpl *,
          TransactionHandle)),
-      &database.m_thread,
+      database.m_worker,
       SLOT(transactionCommitRetaining(
          TsSqlTransactionImpl *,
          TransactionHandle)),
@@ -1399,7 +3485,7 @@ TsSqlTransactionImpl::TsSqlTransactionImpl(
       SIGNAL(transactionRollBackWaiting(
          TsSqlTransactionImpl *,
          TransactionHandle)),
-      &database.m_thread,
+      database.m_worker,
       SLOT(transactionRollBack(
          TsSqlTransactionImpl *,
          TransactionHandle)),
@@ -1411,6 +3497,33 @@ TsSqlTransactionImpl::~TsSqlTransactionImpl()
    emit destroyTransaction(m_handle);
 }
 
+void TsSqlTransactionImpl::customEvent(QEvent *event)
+{
+   if (event->type() != TsSqlNotifier::eventType())
+      return QObject::customEvent(event);
+   while (TsSqlNotification *notification = m_notifier.take())
+   {
+      switch(notification->type)
+      {
+         case ntTransactionStarted:
+            emit started();
+            break;
+         case ntTransactionCommited:
+            emit commited();
+            break;
+         case ntTransactionRolledBack:
+            emit rolledBack();
+            break;
+         case ntError:
+            emit error(notification->errorMessage);
+            break;
+         default:
+            DEBUG_OUT("Unexpected notification " << notification->type << " for transaction " << this);
+      }
+      delete notification;
+   }
+}
+
 void TsSqlTransactionImpl::start()
 {
    emit transactionStart(
@@ -1476,7 +3589,14 @@ TsSqlStatementImpl::TsSqlStatementImpl(
    TsSqlDatabaseImpl &database,
    TsSqlTransactionImpl &transaction):
    m_handle(0),
-   m_stopFetching(false)
+   m_database(database.m_handle),
+   m_stopFetching(false),
+   m_fetchBatchSize(1),
+   m_fetchBatchTime(0),
+   m_readAhead(0),
+   m_fetchBlobIds(false),
+   m_fetching(false),
+   m_notifier(this)
 {
    DEBUG_OUT("Creating new statement");
    connect(
@@ -1485,7 +3605,7 @@ TsSqlStatementImpl::TsSqlStatementImpl(
          TsSqlStatementImpl*,
          DatabaseHandle,
          TransactionHandle)),
-      &database.m_thread,
+      database.m_worker,
       SLOT(createStatement(
          TsSqlStatementImpl*,
          DatabaseHandle,
@@ -1498,14 +3618,23 @@ TsSqlStatementImpl::TsSqlStatementImpl(
       transaction.m_handle);
    DEBUG_OUT("Statement-handle " << m_handle << " arrived for " << this);
 
-   connectSignals(&database.m_thread);
+   connectSignals(database.m_worker);
 }
 
 
 TsSqlStatementImpl::TsSqlStatementImpl(
    TsSqlDatabaseImpl &database, 
    TsSqlTransactionImpl &transaction, 
-   const QString &sql)
+   const QString &sql):
+   m_handle(0),
+   m_database(database.m_handle),
+   m_stopFetching(false),
+   m_fetchBatchSize(1),
+   m_fetchBatchTime(0),
+   m_readAhead(0),
+   m_fetchBlobIds(false),
+   m_fetching(false),
+   m_notifier(this)
 {
    DEBUG_OUT("Creating new statement");
    connect(
@@ -1515,7 +3644,7 @@ TsSqlStatementImpl::TsSqlStatementImpl(
          DatabaseHandle,
          TransactionHandle,
          QString)),
-      &database.m_thread,
+      database.m_worker,
       SLOT(createStatement(
          TsSqlStatementImpl*,
          DatabaseHandle,
@@ -1530,7 +3659,7 @@ TsSqlStatementImpl::TsSqlStatementImpl(
       sql);
    DEBUG_OUT("Statement-handle " << m_handle << " arrived for " << this);
 
-   connectSignals(&database.m_thread);
+   connectSignals(database.m_worker);
 }
 
 TsSqlStatementImpl::~TsSqlStatementImpl()
@@ -1697,6 +3826,34 @@ void TsSqlStatementImpl::connectSignals(QObject *receiver)
          TsSqlRow,
          bool)),
       Qt::BlockingQueuedConnection);
+   connect(
+      this,
+      SIGNAL(statementExecuteBatch(
+         TsSqlStatementImpl *,
+         StatementHandle,
+         TsSqlRowBatch)),
+      receiver,
+      SLOT(statementExecuteBatch(
+         TsSqlStatementImpl *,
+         StatementHandle,
+         TsSqlRowBatch)),
+      Qt::QueuedConnection);
+   connect(
+      this,
+      SIGNAL(statementExecuteBatchWaiting(
+         TsSqlStatementImpl *,
+         StatementHandle,
+         TsSqlRowBatch,
+         int *,
+         TsSqlBatchErrors *)),
+      receiver,
+      SLOT(statementExecuteBatch(
+         TsSqlStatementImpl *,
+         StatementHandle,
+         TsSqlRowBatch,
+         int *,
+         TsSqlBatchErrors *)),
+      Qt::BlockingQueuedConnection);
    connect(
       this,
       SIGNAL(statementSetParam(
@@ -1719,17 +3876,63 @@ void TsSqlStatementImpl::connectSignals(QObject *receiver)
          TsSqlStatementImpl *,
          StatementHandle)),
       Qt::QueuedConnection);
+   connect(
+      this,
+      SIGNAL(statementStopFetch(
+         TsSqlStatementImpl *,
+         StatementHandle)),
+      receiver,
+      SLOT(statementStopFetch(
+         TsSqlStatementImpl *,
+         StatementHandle)),
+      Qt::BlockingQueuedConnection);
    connect(
       this,
       SIGNAL(statementFetchSingleRow(
+         TsSqlStatementImpl *,
          StatementHandle,
          TsSqlRow *)),
       receiver,
       SLOT(statementFetchSingleRow(
+         TsSqlStatementImpl *,
          StatementHandle,
          TsSqlRow *)),
       Qt::BlockingQueuedConnection);
 
+   connect(
+      this,
+      SIGNAL(statementFetchColumns(
+         TsSqlStatementImpl *,
+         StatementHandle,
+         TsSqlColumnarBuffer *,
+         int,
+         int *)),
+      receiver,
+      SLOT(statementFetchColumns(
+         TsSqlStatementImpl *,
+         StatementHandle,
+         TsSqlColumnarBuffer *,
+         int,
+         int *)),
+      Qt::BlockingQueuedConnection);
+
+   connect(
+      this,
+      SIGNAL(statementFetchRows(
+         TsSqlStatementImpl *,
+         StatementHandle,
+         TsSqlRowBatch *,
+         int,
+         int *)),
+      receiver,
+      SLOT(statementFetchRows(
+         TsSqlStatementImpl *,
+         StatementHandle,
+         TsSqlRowBatch *,
+         int,
+         int *)),
+      Qt::BlockingQueuedConnection);
+
    connect(
       this,
       SIGNAL(statementInfo(
@@ -1746,14 +3949,126 @@ void TsSqlStatementImpl::connectSignals(QObject *receiver)
          QVariant,
          QVariant *)),
       Qt::BlockingQueuedConnection);
+   connect(
+      this,
+      SIGNAL(statementLoadBlob(
+         TsSqlStatementImpl *,
+         StatementHandle,
+         const TsSqlBlobId &,
+         QByteArray *,
+         bool *)),
+      receiver,
+      SLOT(statementLoadBlob(
+         TsSqlStatementImpl *,
+         StatementHandle,
+         const TsSqlBlobId &,
+         QByteArray *,
+         bool *)),
+      Qt::BlockingQueuedConnection);
 }
 
-void TsSqlStatementImpl::fetchDataset(const TsSqlRow &row)
+void TsSqlStatementImpl::customEvent(QEvent *event)
 {
-   emit fetched(row);
-   emit statementFetchNext(
-      this,
-      m_handle);
+   if (event->type() != TsSqlNotifier::eventType())
+      return QObject::customEvent(event);
+   while (TsSqlNotification *notification = m_notifier.take())
+   {
+      switch(notification->type)
+      {
+         case ntStatementPrepared:
+            emit prepared();
+            break;
+         case ntStatementExecuted:
+            emit executed();
+            break;
+         case ntStatementBatchExecuted:
+            emit batchExecuted(notification->affectedRows, notification->batchErrors);
+            break;
+         case ntStatementFetchStarted:
+            emit fetchStarted();
+            break;
+         case ntStatementFetched:
+            fetchDatasets(notification->rows, notification->atEnd);
+            break;
+         case ntStatementRowsAvailable:
+            drainFetchQueue();
+            break;
+         case ntStatementFetchFinished:
+            m_fetching = false;
+            emit fetchFinished();
+            break;
+         case ntCancelled:
+            emit cancelled();
+            break;
+         case ntError:
+            emit error(notification->errorMessage);
+            break;
+         default:
+            DEBUG_OUT("Unexpected notification " << notification->type << " for statement " << this);
+      }
+      delete notification;
+   }
+}
+
+void TsSqlStatementImpl::fetchDatasets(const TsSqlRowBatch &rows, bool atEnd)
+{
+   emit fetchedBatch(rows);
+   // Keep delivering single rows for receivers of fetched()
+   for(TsSqlRowBatch::const_iterator i = rows.begin();
+       i != rows.end();
+       ++i)
+      emit fetched(*i);
+   if (atEnd)
+   {
+      m_fetching = false;
+      emit fetchFinished();
+   }
+   else
+      emit statementFetchNext(
+         this,
+         m_handle);
+}
+
+void TsSqlStatementImpl::drainFetchQueue()
+{
+   m_fetchQueue.notified();
+   TsSqlRowBatch rows;
+   TsSqlRow row;
+   while (m_fetchQueue.pop(row))
+   {
+      rows.push_back(row);
+      // Let the database-thread fetch ahead while the rows are delivered
+      if (m_fetchQueue.resumeProducer())
+         emit statementFetchNext(this, m_handle);
+   }
+   if (!rows.isEmpty())
+   {
+      emit fetchedBatch(rows);
+      for(TsSqlRowBatch::const_iterator i = rows.begin();
+          i != rows.end();
+          ++i)
+         emit fetched(*i);
+   }
+   if (m_fetchQueue.takeFinished())
+   {
+      m_fetching = false;
+      emit fetchFinished();
+   }
+}
+
+void TsSqlStatementImpl::prepareFetch()
+{
+   // The queue may only be reset while the database-thread doesn't produce
+   // into it. If the last fetch hasn't finished, it is stopped and the
+   // database-thread acknowledges once the requests before have run.
+   if (m_fetching)
+   {
+      if (m_fetchQueue.capacity() > 0)
+         stopFetching();
+      emit statementStopFetch(this, m_handle);
+   }
+   m_fetchQueue.reset(m_readAhead);
+   m_fetching = true;
 }
 
 void TsSqlStatementImpl::prepare(const QString &sql)
@@ -1763,16 +4078,22 @@ void TsSqlStatementImpl::prepare(const QString &sql)
 
 void TsSqlStatementImpl::execute(bool startFetch)
 {
+   if (startFetch)
+      prepareFetch();
    emit statementExecute(this, m_handle, startFetch);
 }
 
 void TsSqlStatementImpl::execute(const QString &sql, bool startFetch)
 {
+   if (startFetch)
+      prepareFetch();
    emit statementExecute(this, m_handle, sql, startFetch);
 }
 
 void TsSqlStatementImpl::execute(const TsSqlRow &params, bool startFetch)
 {
+   if (startFetch)
+      prepareFetch();
    emit statementExecute(this, m_handle, params, startFetch);
 }
 
@@ -1781,6 +4102,8 @@ void TsSqlStatementImpl::execute(
    const TsSqlRow &params,
    bool startFetch)
 {
+   if (startFetch)
+      prepareFetch();
    emit statementExecute(this, m_handle, sql, params, startFetch);
 }
 
@@ -1811,6 +4134,49 @@ void TsSqlStatementImpl::executeWaiting(
    emit statementExecuteWaiting(this, m_handle, sql, params, false);
 }
 
+void TsSqlStatementImpl::executeBatch(const TsSqlRowBatch &params)
+{
+   emit statementExecuteBatch(this, m_handle, params);
+}
+
+int TsSqlStatementImpl::executeBatchWaiting(
+   const TsSqlRowBatch &params,
+   TsSqlBatchErrors *errors)
+{
+   int result = 0;
+   TsSqlBatchErrors temp;
+   emit statementExecuteBatchWaiting(
+      this,
+      m_handle,
+      params,
+      &result,
+      errors ? errors : &temp);
+   return result;
+}
+
+void TsSqlStatementImpl::bindParam(
+   int column, 
+   TsSqlType type, 
+   const void *value, 
+   const bool *isNull)
+{
+   if (column < 1)
+      return;
+   QMutexLocker locker(&m_bindingMutex);
+   if (m_bindings.size() < column)
+      m_bindings.resize(column);
+   TsSqlParamBinding &binding = m_bindings[column - 1];
+   binding.type   = type;
+   binding.value  = value;
+   binding.isNull = isNull;
+}
+
+void TsSqlStatementImpl::unbind()
+{
+   QMutexLocker locker(&m_bindingMutex);
+   m_bindings.clear();
+}
+
 void TsSqlStatementImpl::setParam(int column, const TsSqlVariant &param)
 {
    emit statementSetParam(
@@ -1836,15 +4202,40 @@ int TsSqlStatementImpl::affectedRows()
 
 void TsSqlStatementImpl::fetch()
 {
+   prepareFetch();
    emit statementStartFetch(this, m_handle);
 }
 
 bool TsSqlStatementImpl::fetchRow(TsSqlRow &row)
 {
-   emit statementFetchSingleRow(m_handle, &row);
+   emit statementFetchSingleRow(this, m_handle, &row);
    return row.size() > 0;
 }
 
+int TsSqlStatementImpl::fetchColumns(TsSqlColumnarBuffer &buffer, int maxRows)
+{
+   int result;
+   emit statementFetchColumns(this, m_handle, &buffer, maxRows, &result);
+   return result;
+}
+
+int TsSqlStatementImpl::fetchRows(TsSqlRowBatch &rows, int maxRows)
+{
+   int result;
+   emit statementFetchRows(this, m_handle, &rows, maxRows, &result);
+   return result;
+}
+
+QByteArray TsSqlStatementImpl::loadBlobWaiting(const TsSqlBlobId &id, bool *ok)
+{
+   QByteArray result;
+   bool loaded;
+   emit statementLoadBlob(this, m_handle, id, &result, &loaded);
+   if (ok)
+      *ok = loaded;
+   return result;
+}
+
 void TsSqlStatementImpl::stopFetching()
 {
    m_stopFetchingMutex.lock();
@@ -1852,112 +4243,473 @@ void TsSqlStatementImpl::stopFetching()
    m_stopFetchingMutex.unlock();
 }
 
+bool TsSqlStatementImpl::cancel()
+{
+   // Cancels the operation running on the statement's attachment, which is
+   // the statement's own, as long as it keeps the database-thread busy.
+   return m_database && DBHANDLE(m_database)->Cancel();
+}
+
+void TsSqlStatementImpl::setFetchBatchSize(int rows)
+{
+   m_fetchBatchMutex.lock();
+   m_fetchBatchSize = std::max(rows, 1);
+   m_fetchBatchMutex.unlock();
+}
+
+void TsSqlStatementImpl::setFetchBatchTime(int msecs)
+{
+   m_fetchBatchMutex.lock();
+   m_fetchBatchTime = std::max(msecs, 0);
+   m_fetchBatchMutex.unlock();
+}
+
+int TsSqlStatementImpl::fetchBatchSize()
+{
+   QMutexLocker locker(&m_fetchBatchMutex);
+   return m_fetchBatchSize;
+}
+
+int TsSqlStatementImpl::fetchBatchTime()
+{
+   QMutexLocker locker(&m_fetchBatchMutex);
+   return m_fetchBatchTime;
+}
+
+void TsSqlStatementImpl::setFetchReadAhead(int rows)
+{
+   m_readAhead = std::max(rows, 0);
+}
+
+int TsSqlStatementImpl::fetchReadAhead()
+{
+   return m_readAhead;
+}
+
+void TsSqlStatementImpl::setFetchBlobIds(bool blobIds)
+{
+   m_fetchBlobIds = blobIds;
+}
+
+bool TsSqlStatementImpl::fetchBlobIds()
+{
+   return m_fetchBlobIds;
+}
+
+void TsSqlStatementImpl::setDescription(
+   const QVector<TsSqlColumnInfo> &columns,
+   const QVector<TsSqlColumnInfo> &params)
+{
+   QMutexLocker locker(&m_descriptionMutex);
+   m_columns = columns;
+   m_params = params;
+}
+
+QVector<TsSqlColumnInfo> TsSqlStatementImpl::columns()
+{
+   QMutexLocker locker(&m_descriptionMutex);
+   return m_columns;
+}
+
+QVector<TsSqlColumnInfo> TsSqlStatementImpl::params()
+{
+   QMutexLocker locker(&m_descriptionMutex);
+   return m_params;
+}
+
 int TsSqlStatementImpl::columnCount()
 {
-   QVariant result;
-   emit statementInfo(
-         this, 
-         m_handle, 
-         siColumnCount, 
-         0,
-         &result);
-   return result.toInt();
+   return columns().size();
 }
 
 QString TsSqlStatementImpl::columnName(int columnIndex)
 {
-   QVariant result;
-   emit statementInfo(
-         this, 
-         m_handle, 
-         siColumnName, 
-         columnIndex,
-         &result);
-   return result.toString();
+   return columns().value(columnIndex).name;
 }
 
 int TsSqlStatementImpl::columnIndex(const QString &columnName)
 {
-   QVariant result;
-   emit statementInfo(
-         this, 
-         m_handle, 
-         siColumnIndex, 
-         columnName,
-         &result);
-   return result.toInt();
+   // Like IBPP, names are searched before aliases and counted from 1
+   QVector<TsSqlColumnInfo> columns = this->columns();
+   for(int i = 0; i < columns.size(); ++i)
+      if (columns[i].name.compare(columnName, Qt::CaseInsensitive) == 0)
+         return i + 1;
+   for(int i = 0; i < columns.size(); ++i)
+      if (columns[i].alias.compare(columnName, Qt::CaseInsensitive) == 0)
+         return i + 1;
+   return 0;
 }
 
 QString TsSqlStatementImpl::columnAlias(int columnIndex)
 {
-   QVariant result;
-   emit statementInfo(
-         this, 
-         m_handle, 
-         siColumnAlias, 
-         columnIndex,
-         &result);
-   return result.toString();
+   return columns().value(columnIndex).alias;
 }
 
 QString TsSqlStatementImpl::columnTable(int columnIndex)
 {
-   QVariant result;
-   emit statementInfo(
-         this, 
-         m_handle, 
-         siColumnTable, 
-         columnIndex,
-         &result);
-   return result.toString();
+   return columns().value(columnIndex).table;
 }
 
 TsSqlType TsSqlStatementImpl::columnType(int columnIndex)
 {
-   QVariant result;
-   emit statementInfo(
-         this, 
-         m_handle, 
-         siColumnType, 
-         columnIndex,
-         &result);
-   return static_cast<TsSqlType>(result.toInt());
+   return columns().value(columnIndex).type;
 }
 
 int TsSqlStatementImpl::columnSubType(int columnIndex)
 {
-   QVariant result;
-   emit statementInfo(
-      this,
-      m_handle,
-      siColumnSubType,
-      columnIndex,
-      &result);
-   return result.toInt();
+   return columns().value(columnIndex).subType;
 }
 
 int TsSqlStatementImpl::columnSize(int columnIndex)
 {
-   QVariant result;
-   emit statementInfo(
-      this,
-      m_handle,
-      siColumnSize,
-      columnIndex,
-      &result);
-   return result.toInt();
+   return columns().value(columnIndex).size;
 }
 
 int TsSqlStatementImpl::columnScale(int columnIndex)
 {
-   QVariant result;
-   emit statementInfo(
+   return columns().value(columnIndex).scale;
+}
+
+int TsSqlStatementImpl::paramCount()
+{
+   return params().size();
+}
+
+TsSqlType TsSqlStatementImpl::paramType(int paramIndex)
+{
+   return params().value(paramIndex).type;
+}
+
+int TsSqlStatementImpl::paramSubType(int paramIndex)
+{
+   return params().value(paramIndex).subType;
+}
+
+int TsSqlStatementImpl::paramSize(int paramIndex)
+{
+   return params().value(paramIndex).size;
+}
+
+int TsSqlStatementImpl::paramScale(int paramIndex)
+{
+   return params().value(paramIndex).scale;
+}
+
+TsSqlBlobReaderImpl::TsSqlBlobReaderImpl(
+   TsSqlDatabaseImpl &database,
+   TsSqlTransactionImpl &transaction,
+   const TsSqlBlobId &id):
+   m_handle(0),
+   m_size(0),
+   m_position(0),
+   m_device(0),
+   m_chunkSize(0),
+   m_stop(false),
+   m_notifier(this)
+{
+   DEBUG_OUT("Creating new blob reader");
+   connect(
       this,
-      m_handle,
-      siColumnScale,
-      columnIndex,
-      &result);
-   return result.toInt();
+      SIGNAL(createBlob(
+         TsSqlBlobReaderImpl *,
+         DatabaseHandle,
+         TransactionHandle,
+         const TsSqlBlobId &)),
+      database.m_worker,
+      SLOT(createBlob(
+         TsSqlBlobReaderImpl *,
+         DatabaseHandle,
+         TransactionHandle,
+         const TsSqlBlobId &)),
+      Qt::BlockingQueuedConnection);
+   connect(
+      this,
+      SIGNAL(destroyBlob(BlobHandle)),
+      database.m_worker,
+      SLOT(destroyBlob(BlobHandle)),
+      Qt::BlockingQueuedConnection);
+
+   emit createBlob(this, database.m_handle, transaction.m_handle, id);
+   DEBUG_OUT("Blob-handle " << m_handle << " arrived for " << this);
+
+   connect(
+      this,
+      SIGNAL(blobRead(
+         TsSqlBlobReaderImpl *,
+         BlobHandle,
+         char *,
+         int,
+         int *)),
+      database.m_worker,
+      SLOT(blobRead(
+         TsSqlBlobReaderImpl *,
+         BlobHandle,
+         char *,
+         int,
+         int *)),
+      Qt::BlockingQueuedConnection);
+   connect(
+      this,
+      SIGNAL(blobReadAll(
+         TsSqlBlobReaderImpl *,
+         BlobHandle,
+         QByteArray *)),
+      database.m_worker,
+      SLOT(blobReadAll(
+         TsSqlBlobReaderImpl *,
+         BlobHandle,
+         QByteArray *)),
+      Qt::BlockingQueuedConnection);
+   connect(
+      this,
+      SIGNAL(blobReadNext(
+         TsSqlBlobReaderImpl *,
+         BlobHandle)),
+      database.m_worker,
+      SLOT(blobReadNext(
+         TsSqlBlobReaderImpl *,
+         BlobHandle)),
+      Qt::QueuedConnection);
+}
+
+TsSqlBlobReaderImpl::~TsSqlBlobReaderImpl()
+{
+   // Queued after a pending blobReadNext, so that one is still served
+   emit destroyBlob(m_handle);
+}
+
+void TsSqlBlobReaderImpl::customEvent(QEvent *event)
+{
+   if (event->type() != TsSqlNotifier::eventType())
+      return QObject::customEvent(event);
+   while (TsSqlNotification *notification = m_notifier.take())
+   {
+      switch(notification->type)
+      {
+         case ntBlobTransferred:
+            emit progress(notification->bytes, notification->totalBytes);
+            // The next chunk is requested only now, so the database-thread
+            // serves other requests in between and stops reading as soon
+            // as this reader is stopped or destroyed.
+            if (notification->atEnd || m_stop)
+            {
+               m_device = 0;
+               emit finished();
+            } else
+               emit blobReadNext(this, m_handle);
+            break;
+         case ntError:
+            m_device = 0;
+            emit error(notification->errorMessage);
+            break;
+         default:
+            DEBUG_OUT("Unexpected notification " << notification->type << " for blob reader " << this);
+      }
+      delete notification;
+   }
+}
+
+int TsSqlBlobReaderImpl::size()
+{
+   return m_size;
+}
+
+int TsSqlBlobReaderImpl::readWaiting(char *data, int maxSize)
+{
+   if (!m_handle || m_device || maxSize <= 0)
+      return 0;
+   int result = 0;
+   emit blobRead(this, m_handle, data, maxSize, &result);
+   return result;
+}
+
+QByteArray TsSqlBlobReaderImpl::readAllWaiting()
+{
+   QByteArray result;
+   if (m_handle && !m_device)
+      emit blobReadAll(this, m_handle, &result);
+   return result;
+}
+
+void TsSqlBlobReaderImpl::read(QIODevice *device, int chunkSize)
+{
+   if (!m_handle || m_device || !device)
+      return;
+   m_device = device;
+   m_chunkSize = std::max(chunkSize, 1);
+   m_stop = false;
+   emit blobReadNext(this, m_handle);
+}
+
+void TsSqlBlobReaderImpl::stop()
+{
+   m_stop = true;
+}
+
+TsSqlBlobWriterImpl::TsSqlBlobWriterImpl(
+   TsSqlDatabaseImpl &database,
+   TsSqlTransactionImpl &transaction):
+   m_handle(0),
+   m_size(0),
+   m_deviceSize(-1),
+   m_device(0),
+   m_file(0),
+   m_chunkSize(0),
+   m_stop(false),
+   m_notifier(this)
+{
+   DEBUG_OUT("Creating new blob writer");
+   connect(
+      this,
+      SIGNAL(createBlob(
+         TsSqlBlobWriterImpl *,
+         DatabaseHandle,
+         TransactionHandle)),
+      database.m_worker,
+      SLOT(createBlob(
+         TsSqlBlobWriterImpl *,
+         DatabaseHandle,
+         TransactionHandle)),
+      Qt::BlockingQueuedConnection);
+   connect(
+      this,
+      SIGNAL(destroyBlob(BlobHandle)),
+      database.m_worker,
+      SLOT(destroyBlob(BlobHandle)),
+      Qt::BlockingQueuedConnection);
+
+   emit createBlob(this, database.m_handle, transaction.m_handle);
+   DEBUG_OUT("Blob-handle " << m_handle << " arrived for " << this);
+
+   connect(
+      this,
+      SIGNAL(blobWrite(
+         TsSqlBlobWriterImpl *,
+         BlobHandle,
+         const char *,
+         int)),
+      database.m_worker,
+      SLOT(blobWrite(
+         TsSqlBlobWriterImpl *,
+         BlobHandle,
+         const char *,
+         int)),
+      Qt::BlockingQueuedConnection);
+   connect(
+      this,
+      SIGNAL(blobWriteNext(
+         TsSqlBlobWriterImpl *,
+         BlobHandle)),
+      database.m_worker,
+      SLOT(blobWriteNext(
+         TsSqlBlobWriterImpl *,
+         BlobHandle)),
+      Qt::QueuedConnection);
+   connect(
+      this,
+      SIGNAL(blobClose(
+         TsSqlBlobWriterImpl *,
+         BlobHandle,
+         TsSqlBlobId *)),
+      database.m_worker,
+      SLOT(blobClose(
+         TsSqlBlobWriterImpl *,
+         BlobHandle,
+         TsSqlBlobId *)),
+      Qt::BlockingQueuedConnection);
+}
+
+TsSqlBlobWriterImpl::~TsSqlBlobWriterImpl()
+{
+   // A blob still being written is cancelled by IBPP
+   emit destroyBlob(m_handle);
+   delete m_file;
+}
+
+void TsSqlBlobWriterImpl::customEvent(QEvent *event)
+{
+   if (event->type() != TsSqlNotifier::eventType())
+      return QObject::customEvent(event);
+   while (TsSqlNotification *notification = m_notifier.take())
+   {
+      switch(notification->type)
+      {
+         case ntBlobTransferred:
+            emit progress(notification->bytes, notification->totalBytes);
+            if (notification->atEnd || m_stop)
+            {
+               finishWrite();
+               emit finished();
+            } else
+               emit blobWriteNext(this, m_handle);
+            break;
+         case ntError:
+            finishWrite();
+            emit error(notification->errorMessage);
+            break;
+         default:
+            DEBUG_OUT("Unexpected notification " << notification->type << " for blob writer " << this);
+      }
+      delete notification;
+   }
+}
+
+void TsSqlBlobWriterImpl::finishWrite()
+{
+   m_device = 0;
+   delete m_file;
+   m_file = 0;
+   m_buffer.clear();
+}
+
+qint64 TsSqlBlobWriterImpl::size()
+{
+   return m_size;
+}
+
+void TsSqlBlobWriterImpl::writeWaiting(const char *data, int size)
+{
+   if (m_handle && !m_device && size > 0)
+      emit blobWrite(this, m_handle, data, size);
+}
+
+void TsSqlBlobWriterImpl::write(QIODevice *device, int chunkSize)
+{
+   if (!m_handle || m_device || !device)
+      return;
+   m_device = device;
+   m_deviceSize = device->isSequential() ? -1 : device->size() - device->pos();
+   m_chunkSize = std::max(chunkSize, 1);
+   m_stop = false;
+   emit blobWriteNext(this, m_handle);
+}
+
+bool TsSqlBlobWriterImpl::writeFile(const QString &fileName, int chunkSize)
+{
+   if (!m_handle || m_device)
+      return false;
+   m_file = new QFile(fileName);
+   if (!m_file->open(QIODevice::ReadOnly))
+   {
+      delete m_file;
+      m_file = 0;
+      return false;
+   }
+   write(m_file, chunkSize);
+   return true;
+}
+
+void TsSqlBlobWriterImpl::stop()
+{
+   m_stop = true;
+}
+
+TsSqlBlobId TsSqlBlobWriterImpl::closeWaiting()
+{
+   TsSqlBlobId result = {0, 0};
+   if (m_handle && !m_device)
+      emit blobClose(this, m_handle, &result);
+   return result;
 }
 
 namespace
@@ -1971,12 +4723,16 @@ namespace
          qRegisterMetaType<DatabaseHandle>();
          qRegisterMetaType<TransactionHandle>();
          qRegisterMetaType<StatementHandle>();
+         qRegisterMetaType<BlobHandle>();
 
          qRegisterMetaType<DatabaseInfo>();
          qRegisterMetaType<StatementInfo>();
 
          qRegisterMetaType<TsSqlVariant>();
          qRegisterMetaType<TsSqlRow>();
+         qRegisterMetaType<TsSqlRowBatch>();
+         qRegisterMetaType<TsSqlBatchErrors>();
+         qRegisterMetaType<TsSqlBlobId>();
          qRegisterMetaType<TsSqlTransaction::TransactionMode>();
       }
    } g_sqlMetaTypeInitializer;
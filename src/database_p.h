@@ -4,20 +4,151 @@
 
 #include <QThread>
 #include <QMutex>
+#include <QReadWriteLock>
 #include <QPair>
+#include <QAtomicInt>
+#include <QAtomicPointer>
+#include <QEvent>
+#include <QHash>
+#include <QList>
+#include <QWaitCondition>
+#include <QFile>
+#include <QCache>
+
+struct TsSqlColumnData
+{
+   QString          name;
+   TsSqlType        type;
+   QVector<char>    values;  // fixed-size values, or the bytes of all strings
+   QVector<int>     offsets; // strings and blobs, only
+   QVector<quint32> nulls;
+};
+
+class TsSqlColumnarBufferImpl
+{
+   public:
+      int m_rowCount;
+      QVector<TsSqlColumnData> m_columns;
+      TsSqlColumnarBufferImpl();
+      void clear();
+      void setColumns(const QVector<QString> &names, const QVector<TsSqlType> &types);
+      void setNull(int column, int row);
+      void truncate(int rowCount);
+      template<typename T>
+         const T *typedColumn(int column, TsSqlType type) const;
+      template<typename T>
+         void appendValue(int column, const T &value);
+      void appendString(int column, const char *data, int size);
+};
+
+struct TsSqlPooledDatabase
+{
+   TsSqlDatabase *database;
+   QTime          idleSince;
+};
+
+struct TsSqlConnectionPoolEntry
+{
+   QList<TsSqlPooledDatabase> idle; // the most recently released one last
+   int leased;                      // including the ones being opened
+   TsSqlConnectionPoolEntry(): leased(0) {}
+};
+
+class TsSqlConnectionPoolImpl
+{
+   private:
+      QMutex m_mutex;
+      QWaitCondition m_released; // shared by the waiters of all keys
+      int m_minimumSize, m_maximumSize, m_idleTimeout, m_validationInterval;
+      QHash<QString, TsSqlConnectionPoolEntry> m_entries;
+      QHash<TsSqlDatabase*, QString> m_leases;
+      TsSqlConnectionPool::Statistics m_statistics;
+      void takeExpired(QList<TsSqlDatabase*> &expired);
+      void endLease(TsSqlDatabase *database);
+      static void attach(TsSqlDatabase *database);
+      static void detach(TsSqlDatabase *database);
+      static void destroy(const QList<TsSqlDatabase*> &databases);
+   public:
+      TsSqlConnectionPoolImpl(
+         int minimumSize,
+         int maximumSize,
+         int idleTimeout,
+         int validationInterval);
+      ~TsSqlConnectionPoolImpl();
+      void setMinimumSize(int size);
+      void setMaximumSize(int size);
+      void setIdleTimeout(int msecs);
+      void setValidationInterval(int msecs);
+      int  minimumSize();
+      int  maximumSize();
+      int  idleTimeout();
+      int  validationInterval();
+      TsSqlDatabase *acquire(
+         const QString &server,
+         const QString &database,
+         const QString &user,
+         const QString &password,
+         const QString &characterSet,
+         const QString &role,
+         int timeout);
+      void release(TsSqlDatabase *database);
+      void expire();
+      TsSqlConnectionPool::Statistics statistics();
+};
+
+typedef QPair<bool, TsSqlRow> TsSqlBufferItem; // resolved, row
+
+// The rows of a TsSqlBuffer are kept in chunks of a fixed size, which never
+// move once they are allocated, so appending doesn't copy the rows before.
+struct TsSqlBufferChunk
+{
+   enum { size = 1024 };
+   TsSqlBufferItem items[size];
+};
 
 class TsSqlBufferImpl: public QObject
 {
    Q_OBJECT
    private:
-      mutable QMutex m_mutex;
-      QVector<QPair<bool, TsSqlRow> > m_rows;
-      TsSqlStatement *m_data, *m_fetch;
+      // Guards the chunks and the rows in them, the viewport and the
+      // prefetch's state. It is never held while waiting for the database.
+      // m_count publishes the number of complete rows, it is read without
+      // a lock.
+      mutable QReadWriteLock m_lock;
+      QVector<TsSqlBufferChunk*> m_chunks;
+      QAtomicInt m_count;
+      QMutex m_dataMutex;     // serializes resolving by the data statement
+      QAtomicInt m_batchBusy; // 1 while the batch statement is in use
+      TsSqlStatement *m_data, *m_fetch, *m_batch, *m_prefetch;
+      int m_batchSize;
+      unsigned m_viewFirst, m_viewLast, m_margin;
+      bool m_prefetching;
+      bool m_prefetchRetried; // the last prefetch failed and was started again
+      QHash<int, unsigned> m_prefetchIndex; // key -> row of the prefetch
       unsigned m_colCount;
+      bool m_lazyBlobs;
+      QMutex m_cacheMutex;
+      QCache<quint64, QString> m_blobCache; // the cost is a blob's size
+      TsSqlBufferItem &item(unsigned row);
+      const TsSqlBufferItem &item(unsigned row) const;
+      void freeChunks();
+      void loadBlob(TsSqlVariant &value);
+      void resolve(unsigned row);
+      void resolveSingle(unsigned row);
+      void resolveBatch(unsigned row);
+      void collectUnresolved(int first, int last, QVector<unsigned> &rows);
+      TsSqlRow batchParams(const QVector<unsigned> &rows, QHash<int, unsigned> &index);
+      bool storeRow(unsigned row, int key, const TsSqlRow &data);
+      int  storeFetched(const TsSqlRow &row, const QHash<int, unsigned> &index);
+      void appendRows(const TsSqlRowBatch &rows, bool resolved);
    private slots:
-      void appendEmptyRow(const TsSqlRow &row);
+      void appendEmptyRows(const TsSqlRowBatch &rows);
+      void appendRows(const TsSqlRowBatch &rows);
       void updateColumnCount();
-      void validateRow(unsigned row);
+      void schedulePrefetch();
+      void prefetched(const TsSqlRowBatch &rows);
+      void prefetchFinished();
+      void prefetchFailed();
    public:
       TsSqlBufferImpl();
       TsSqlBufferImpl(TsSqlStatement &dataStatement);
@@ -25,6 +156,7 @@ class TsSqlBufferImpl: public QObject
          TsSqlStatement &dataStatement, 
          TsSqlStatement &fetchStatement);
       TsSqlBufferImpl(const TsSqlBufferImpl &copy);
+      ~TsSqlBufferImpl();
       void setStatements(TsSqlStatement *dataStatement, TsSqlStatement *fetchStatement = 0);
    public slots:
       void clear();
@@ -34,16 +166,33 @@ class TsSqlBufferImpl: public QObject
       // It COPIES the row, otherwise it was not thread-safe.
       TsSqlRow getRow(unsigned index);
       void setRow(unsigned index, const TsSqlRow &row);
+      TsSqlVariant cell(unsigned row, unsigned column);
+      void withRow(unsigned row, TsSqlRowVisitor visitor, void *context);
       unsigned count() const;
       unsigned columnCount() const;
+      void setLazyBlobs(bool lazy, int cacheSize);
+      bool lazyBlobs() const;
       TsSqlStatement *dataStatement();
       TsSqlStatement *fetchStatement();
+      void setBatchStatement(
+         TsSqlStatement *batchStatement,
+         int batchSize,
+         TsSqlStatement *prefetchStatement = 0);
+      TsSqlStatement *batchStatement();
+      TsSqlStatement *prefetchStatement();
+      int batchSize() const;
+      void setViewport(unsigned first, unsigned last);
+      void setPrefetchMargin(unsigned rows);
+      unsigned prefetchMargin() const;
+      bool isResolved(unsigned row) const;
    signals:
       void cleared();
       void rowAppended();
-      void rowDeleted();
+      void rowDeleted(unsigned index);
       void columnsChanged();
       void rowFetched(TsSqlRow row);
+      void rowsResolved(unsigned first, unsigned last);
+      void rowsAppended(unsigned first, unsigned last);
 };
 
 // These fakes are necessary so the Qt meta-object system
@@ -53,10 +202,12 @@ class TsSqlBufferImpl: public QObject
 class FakeDatabase;
 class FakeTransaction;
 class FakeStatement;
+class FakeBlob;
 
 typedef FakeDatabase *DatabaseHandle;
 typedef FakeTransaction *TransactionHandle;
 typedef FakeStatement *StatementHandle;
+typedef FakeBlob *BlobHandle;
 
 enum DatabaseInfo
 {
@@ -71,26 +222,98 @@ enum DatabaseInfo
 
 enum StatementInfo
 {
-   siPlan,
-   siColumnCount,
-   siColumnName,
-   siColumnIndex,
-   siColumnAlias,
-   siColumnTable,
-   siColumnType,
-   siColumnSubType,
-   siColumnSize,
-   siColumnScale
+   siPlan
 };
 
-class TsSqlThreadEmitter: public QObject
+// Bounded ring of fetched rows, used for read-ahead fetching.
+// The database-thread is the only producer and the thread owning the
+// statement is the only consumer, so it works without locks.
+// When the ring is full, the producer does not block (it would block all
+// other requests to the database-thread, too), but returns and waits for
+// the consumer to resume it.
+class TsSqlFetchQueue
 {
-   Q_OBJECT
    private:
-      QObject *m_object;
+      QVector<TsSqlRow> m_rows;
+      int        m_capacity;
+      QAtomicInt m_head;             // next slot to read
+      QAtomicInt m_tail;             // next slot to write
+      QAtomicInt m_finished;         // 0: fetching, 1: at end, 2: end reported
+      QAtomicInt m_producerWaiting;
+      QAtomicInt m_consumerNotified;
+   public:
+      TsSqlFetchQueue();
+      void reset(int capacity); // consumer, only while nothing is fetched
+
+      int  capacity() const;
+      int  count() const;
+      bool isEmpty() const;
+      bool isFull() const;
 
+      /* Producer-side */
+      TsSqlRow &nextSlot();
+      bool push();              // returns true if the consumer must be notified
+      bool waitForSpace();      // returns false if the ring is not full anymore
+      void finish();
+
+      /* Consumer-side */
+      bool pop(TsSqlRow &row);
+      bool resumeProducer();    // returns true if the producer must be resumed
+      void notified();
+      bool takeFinished();      // returns true once, when all rows were read
+};
+
+enum NotificationType
+{
+   ntDatabaseOpened,
+   ntDatabaseClosed,
+   ntTransactionStarted,
+   ntTransactionCommited,
+   ntTransactionRolledBack,
+   ntStatementPrepared,
+   ntStatementExecuted,
+   ntStatementBatchExecuted,
+   ntStatementFetchStarted,
+   ntStatementFetched,
+   ntStatementRowsAvailable,
+   ntStatementFetchFinished,
+   ntBlobTransferred,
+   ntCancelled,
+   ntError
+};
+
+struct TsSqlNotification
+{
+   NotificationType   type;
+   TsSqlRowBatch      rows;
+   bool               atEnd;
+   int                affectedRows;
+   qint64             bytes, totalBytes;
+   TsSqlBatchErrors   batchErrors;
+   QString            errorMessage;
+   TsSqlNotification *next;
+};
+
+// Delivers notifications from the database-thread to one object living in
+// another thread. Any thread may push, only the object's thread takes.
+// Notifications are collected in a lock-free list and one event is posted
+// to the object whenever the list was empty; the object handles all
+// notifications pending at that time in it's customEvent().
+class TsSqlNotifier
+{
+   private:
+      QObject *m_object;
+      QAtomicPointer<TsSqlNotification> m_pushed;  // newest first
+      TsSqlNotification *m_taken;                  // oldest first
+      void push(TsSqlNotification *notification);
+      void push(NotificationType type);
+      TsSqlNotifier(const TsSqlNotifier &);
+      TsSqlNotifier &operator=(const TsSqlNotifier &);
    public:
-      TsSqlThreadEmitter(QObject *object);
+      TsSqlNotifier(QObject *object);
+      ~TsSqlNotifier();
+      static QEvent::Type eventType();
+
       void emitDatabaseOpened();
       void emitDatabaseClosed();
 
@@ -100,43 +323,122 @@ class TsSqlThreadEmitter: public QObject
 
       void emitStatementPrepared();
       void emitStatementExecuted();
+      void emitStatementBatchExecuted(int affectedRows, const TsSqlBatchErrors &errors);
       void emitStatementFetchStarted();
-      void emitStatementFetched(const TsSqlRow &row);
+      void emitStatementFetched(const TsSqlRowBatch &rows, bool atEnd);
+      void emitStatementRowsAvailable();
       void emitStatementFetchFinished();
 
+      void emitBlobTransferred(qint64 bytes, qint64 totalBytes, bool atEnd);
+
+      void emitCancelled();
       void emitError(const QString  &errorMessage);
-   signals:
-      void databaseOpened();
-      void databaseClosed();
 
-      void transactionStarted();
-      void transactionCommited();
-      void transactionRolledBack();
+      // Returns the oldest pending notification, which the caller
+      // must delete, or 0.
+      TsSqlNotification *take();
+};
+
+// A thread of the TsSqlWorkerPool
+class TsSqlWorkerThread: public QThread
+{
+   public:
+      int workers;        // the number of workers on it, guarded by the pool
+      QAtomicInt running; // 1 while it runs a request
+      TsSqlWorkerThread(): workers(0), running(0) {}
+};
+
+// The threads shared by all database-workers. Each worker handles the
+// requests of one attachment one after the other, on the thread it lives
+// on, while idle attachments don't occupy a thread of their own.
+// A slow request must not stall the workers waiting behind it on the same
+// thread, so when a worker whose last request was slow starts the next
+// one, the pool moves the other workers of that thread (and their queued
+// requests) to threads which are not running a request. New threads are
+// started for them up to maximumThreads(), only if all of them are busy,
+// the others wait. Other requests only mark their thread as running.
+class TsSqlWorkerPool
+{
+   private:
+      QMutex m_mutex;
+      int m_maximumThreads;
+      QVector<TsSqlWorkerThread*> m_threads;
+      QList<QObject*> m_assigned;
+      int freeThread(int except);
+   public:
+      TsSqlWorkerPool();
+      ~TsSqlWorkerPool();
+      static TsSqlWorkerPool *instance();
+      void setMaximumThreads(int count);
+      int  maximumThreads();
+      void assign(QObject *worker);
+      void release(QObject *worker);
+      // Called by a worker on it's thread around each request, slow tells
+      // if it's last request took longer than slowRequestMsecs
+      enum { slowRequestMsecs = 50 };
+      void beginRequest(QObject *worker, bool slow);
+      void endRequest(QObject *worker);
+};
 
-      void statementPrepared();
-      void statementExecuted();
-      void statementFetchStarted();
-      void statementFetched(TsSqlRow);
-      void statementFetchFinished();
+// A parameter bound to a variable of the caller by TsSqlStatement::bind()
+struct TsSqlParamBinding
+{
+   TsSqlType   type;
+   const void *value; // 0 if the parameter is not bound
+   const bool *isNull;
+   TsSqlParamBinding(): type(stUnknown), value(0), isNull(0) {}
+};
 
-      void error(QString);
+struct TsSqlCachedStatement
+{
+   QString         sql; // normalized
+   void           *transaction;
+   StatementHandle statement;
 };
 
-class TsSqlDatabaseThread: public QThread
+// Executes the requests of one database and it's transactions and
+// statements, in the order they were sent.
+// Statements prepared from SQL-text are kept in a least-recently-used
+// cache per transaction, to be reused when the same SQL is prepared again.
+class TsSqlDatabaseWorker: public QObject
 {
    Q_OBJECT
    private:
       std::vector<DatabaseHandle>    m_databaseHandles;
       std::vector<TransactionHandle> m_transactionHandles;
       std::vector<StatementHandle>   m_statementHandles;
+      std::vector<BlobHandle>        m_blobHandles;
+      QList<TsSqlCachedStatement>    m_statementCache; // least recently used first
+      int m_statementCacheSize; // only used on the database-thread
+      QAtomicInt m_statementCacheHits, m_statementCacheMisses;
+      int m_lastRequestMsecs; // how long the last request ran
 
-      void readRow(StatementHandle statement, TsSqlRow &row);
-      void emitStatementRow(TsSqlStatementImpl *receiver, StatementHandle statement);
+      bool cacheStatement(StatementHandle statement);
+      void prepareStatement(StatementHandle statement, const QString &sql);
+      void executeStatement(StatementHandle statement);
+      void clearStatementCache();
+      void setBoundParams(TsSqlStatementImpl *object, StatementHandle statement);
+      int  executeBatch(
+         StatementHandle statement,
+         const TsSqlRowBatch &params,
+         TsSqlBatchErrors &errors);
+
+      void readRow(
+         TsSqlStatementImpl *object,
+         StatementHandle statement,
+         TsSqlRow &row);
+      void emitStatementRows(TsSqlStatementImpl *receiver, StatementHandle statement);
+      void produceRows(TsSqlStatementImpl *receiver, StatementHandle statement);
       void setParams(StatementHandle statement, const TsSqlRow &params);
+      void describeStatement(TsSqlStatementImpl *object, StatementHandle statement);
    protected:
-      virtual void run();
+      virtual bool event(QEvent *event);
    public:
-      TsSqlDatabaseThread();
+      enum { defaultStatementCacheSize = 32 };
+      TsSqlDatabaseWorker();
+      // These may be called from any thread
+      int  statementCacheHits() const;
+      int  statementCacheMisses() const;
    public slots:
       void test();
       void createDatabase(
@@ -149,12 +451,17 @@ class TsSqlDatabaseThread: public QThread
          const QString &role,
          const QString &createParams);
       void destroyDatabase(DatabaseHandle handle);
+      void setStatementCacheSize(int size);
       void databaseOpen(TsSqlDatabaseImpl *object, DatabaseHandle handle);
       void databaseClose(TsSqlDatabaseImpl *object, DatabaseHandle handle);
       void databaseIsOpen(
          TsSqlDatabaseImpl *object, 
          DatabaseHandle handle, 
          bool *result);
+      void databasePing(
+         TsSqlDatabaseImpl *object,
+         DatabaseHandle handle,
+         bool *result);
       void databaseInfo(
          TsSqlDatabaseImpl *object, 
          DatabaseHandle handle, 
@@ -217,6 +524,16 @@ class TsSqlDatabaseThread: public QThread
          const QString &sql,
          const TsSqlRow &params,
          bool startFetch);
+      void statementExecuteBatch(
+         TsSqlStatementImpl *object,
+         StatementHandle handle,
+         const TsSqlRowBatch &params);
+      void statementExecuteBatch(
+         TsSqlStatementImpl *object,
+         StatementHandle handle,
+         const TsSqlRowBatch &params,
+         int *affectedRows,
+         TsSqlBatchErrors *errors);
       void statementSetParam(
          StatementHandle handle,
          int column,
@@ -228,30 +545,113 @@ class TsSqlDatabaseThread: public QThread
       void statementFetchNext(
          TsSqlStatementImpl *object,
          StatementHandle handle);
+      void statementStopFetch(
+         TsSqlStatementImpl *object,
+         StatementHandle handle);
       void statementFetchSingleRow(
+         TsSqlStatementImpl *object,
          StatementHandle handle,
          TsSqlRow *result);
+      void statementFetchColumns(
+         TsSqlStatementImpl *object,
+         StatementHandle handle,
+         TsSqlColumnarBuffer *buffer,
+         int maxRows,
+         int *result);
+      void statementFetchRows(
+         TsSqlStatementImpl *object,
+         StatementHandle handle,
+         TsSqlRowBatch *rows,
+         int maxRows,
+         int *result);
       void statementInfo(
          TsSqlStatementImpl *object, 
          StatementHandle handle, 
          StatementInfo info,
          QVariant param,
          QVariant *result);
+      void statementLoadBlob(
+         TsSqlStatementImpl *object,
+         StatementHandle handle,
+         const TsSqlBlobId &id,
+         QByteArray *result,
+         bool *ok);
+
+      void createBlob(
+         class TsSqlBlobReaderImpl *object,
+         DatabaseHandle database,
+         TransactionHandle transaction,
+         const TsSqlBlobId &id);
+      void destroyBlob(BlobHandle handle);
+      void blobRead(
+         TsSqlBlobReaderImpl *object,
+         BlobHandle handle,
+         char *data,
+         int maxSize,
+         int *result);
+      void blobReadAll(
+         TsSqlBlobReaderImpl *object,
+         BlobHandle handle,
+         QByteArray *result);
+      void blobReadNext(
+         TsSqlBlobReaderImpl *object,
+         BlobHandle handle);
+
+      void createBlob(
+         class TsSqlBlobWriterImpl *object,
+         DatabaseHandle database,
+         TransactionHandle transaction);
+      void blobWrite(
+         TsSqlBlobWriterImpl *object,
+         BlobHandle handle,
+         const char *data,
+         int size);
+      void blobWriteNext(
+         TsSqlBlobWriterImpl *object,
+         BlobHandle handle);
+      void blobClose(
+         TsSqlBlobWriterImpl *object,
+         BlobHandle handle,
+         TsSqlBlobId *result);
    signals:
       void emitStatementFetchNext(
          TsSqlStatementImpl *object,
          StatementHandle handle);
 };
 
+template<typename T>
+const T *TsSqlColumnarBufferImpl::typedColumn(int column, TsSqlType type) const
+{
+   const TsSqlColumnData &data = m_columns[column];
+   if (data.type != type)
+      return 0;
+   return reinterpret_cast<const T*>(data.values.constData());
+}
+
+template<typename T>
+void TsSqlColumnarBufferImpl::appendValue(int column, const T &value)
+{
+   QVector<char> &values = m_columns[column].values;
+   int size = values.size();
+   values.resize(size + sizeof(T));
+   memcpy(values.data() + size, &value, sizeof(T));
+}
+
 class TsSqlDatabaseImpl: public QObject
 {
    Q_OBJECT
    private:
       DatabaseHandle m_handle;
-      TsSqlDatabaseThread m_thread;
-      friend class TsSqlDatabaseThread;
+      TsSqlDatabaseWorker *m_worker;
+      TsSqlNotifier m_notifier;
+      int m_statementCacheSize; // as last set, the worker follows queued
+      friend class TsSqlDatabaseWorker;
       friend class TsSqlTransactionImpl;
       friend class TsSqlStatementImpl;
+      friend class TsSqlBlobReaderImpl;
+      friend class TsSqlBlobWriterImpl;
+   protected:
+      virtual void customEvent(QEvent *event);
    public:
       TsSqlDatabaseImpl(
          const QString &server,
@@ -268,6 +668,12 @@ class TsSqlDatabaseImpl: public QObject
       void openWaiting();   // sync
       void closeWaiting();  // sync
       bool isOpen();
+      bool ping();          // sync
+      bool cancel();        // any thread
+      void setStatementCacheSize(int size);
+      int  statementCacheSize();
+      int  statementCacheHits();
+      int  statementCacheMisses();
       QString server();
       QString database();
       QString user();
@@ -289,11 +695,13 @@ class TsSqlDatabaseImpl: public QObject
          const QString &role,
          const QString &createParams);
       void destroyHandle(DatabaseHandle handle);
+      void databaseSetStatementCacheSize(int size);
       void databaseOpen(TsSqlDatabaseImpl *object, DatabaseHandle handle);
       void databaseClose(TsSqlDatabaseImpl *object, DatabaseHandle handle);
       void databaseOpenWaiting(TsSqlDatabaseImpl *object, DatabaseHandle handle);
       void databaseCloseWaiting(TsSqlDatabaseImpl *object, DatabaseHandle handle);
       void databaseIsOpen(TsSqlDatabaseImpl*object, DatabaseHandle handle, bool *result);
+      void databasePing(TsSqlDatabaseImpl *object, DatabaseHandle handle, bool *result);
       void databaseInfo(
          TsSqlDatabaseImpl *object, 
          DatabaseHandle handle, 
@@ -307,6 +715,7 @@ class TsSqlDatabaseImpl: public QObject
       /* These signals are forwarded to the interface */
       void opened();
       void closed();
+      void cancelled();
       void error(const QString &error);
 };
 
@@ -315,7 +724,12 @@ class TsSqlTransactionImpl: public QObject
    Q_OBJECT
    private:
       TransactionHandle m_handle;
+      TsSqlNotifier m_notifier;
       friend class TsSqlStatementImpl;
+      friend class TsSqlBlobReaderImpl;
+      friend class TsSqlBlobWriterImpl;
+   protected:
+      virtual void customEvent(QEvent *event);
    public:
       TsSqlTransactionImpl(TsSqlDatabaseImpl &database, TsSqlTransaction::TransactionMode mode);
       ~TsSqlTransactionImpl();
@@ -331,7 +745,7 @@ class TsSqlTransactionImpl: public QObject
       void rollBackWaiting();        // sync
 
       bool isStarted();
-      friend class TsSqlDatabaseThread;
+      friend class TsSqlDatabaseWorker;
    signals:
       void createTransaction(
          TsSqlTransactionImpl *object,
@@ -374,16 +788,30 @@ class TsSqlStatementImpl: public QObject
    Q_OBJECT
    private:
       StatementHandle m_handle;
+      DatabaseHandle m_database;
       QMutex m_stopFetchingMutex;
       bool m_stopFetching;
+      QMutex m_fetchBatchMutex;
+      int m_fetchBatchSize, m_fetchBatchTime;
+      int m_readAhead;
+      bool m_fetchBlobIds;
+      TsSqlFetchQueue m_fetchQueue;
+      bool m_fetching; // a fetch was started and hasn't finished yet
+      TsSqlNotifier m_notifier;
+      QMutex m_descriptionMutex;
+      QVector<TsSqlColumnInfo> m_columns, m_params;
+      QMutex m_bindingMutex;
+      QVector<TsSqlParamBinding> m_bindings;
       void connectSignals(QObject *receiver);
-      friend class TsSqlDatabaseThread;
-   public slots:
-      void fetchDataset(const TsSqlRow &row);
-      void emitPrepared()
-      {
-         emit prepared();
-      }
+      void setDescription(
+         const QVector<TsSqlColumnInfo> &columns,
+         const QVector<TsSqlColumnInfo> &params);
+      void prepareFetch();
+      void fetchDatasets(const TsSqlRowBatch &rows, bool atEnd);
+      void drainFetchQueue();
+      friend class TsSqlDatabaseWorker;
+   protected:
+      virtual void customEvent(QEvent *event);
    public:
       TsSqlStatementImpl(
          TsSqlDatabaseImpl &database, 
@@ -411,15 +839,41 @@ class TsSqlStatementImpl: public QObject
          const QString &sql, 
          const TsSqlRow &params); // async
 
+      void executeBatch(const TsSqlRowBatch &params); // async
+      int  executeBatchWaiting(
+         const TsSqlRowBatch &params,
+         TsSqlBatchErrors *errors); // sync
+
       void setParam(int column, const TsSqlVariant &param); // sync
+      void bindParam(
+         int column, 
+         TsSqlType type, 
+         const void *value, 
+         const bool *isNull);
+      void unbind();
 
       QString sql();
       QString plan();
       int affectedRows();
       void fetch();                 // async
       bool fetchRow(TsSqlRow &row); // sync
+      int  fetchColumns(TsSqlColumnarBuffer &buffer, int maxRows); // sync
+      int  fetchRows(TsSqlRowBatch &rows, int maxRows); // sync
       void stopFetching();          // async
+      bool cancel();                // any thread
+      QByteArray loadBlobWaiting(const TsSqlBlobId &id, bool *ok = 0); // sync
+
+      void setFetchBatchSize(int rows);   // sync
+      void setFetchBatchTime(int msecs);  // sync
+      int  fetchBatchSize();
+      int  fetchBatchTime();
+      void setFetchReadAhead(int rows);
+      int  fetchReadAhead();
+      void setFetchBlobIds(bool blobIds);
+      bool fetchBlobIds();
 
+      QVector<TsSqlColumnInfo> columns();
+      QVector<TsSqlColumnInfo> params();
       int        columnCount();
       QString    columnName(   int columnIndex);
       int        columnIndex(  const QString &columnName);
@@ -429,6 +883,11 @@ class TsSqlStatementImpl: public QObject
       int        columnSubType(int columnIndex);
       int        columnSize   (int columnIndex);
       int        columnScale  (int columnIndex);
+      int        paramCount();
+      TsSqlType  paramType(   int paramIndex);
+      int        paramSubType(int paramIndex);
+      int        paramSize   (int paramIndex);
+      int        paramScale  (int paramIndex);
    signals:
       void createStatement(
          TsSqlStatementImpl *object,
@@ -490,6 +949,16 @@ class TsSqlStatementImpl: public QObject
          const QString &sql,
          const TsSqlRow &params,
          bool startFetch);
+      void statementExecuteBatch(
+         TsSqlStatementImpl *object,
+         StatementHandle handle,
+         const TsSqlRowBatch &params);
+      void statementExecuteBatchWaiting(
+         TsSqlStatementImpl *object,
+         StatementHandle handle,
+         const TsSqlRowBatch &params,
+         int *affectedRows,
+         TsSqlBatchErrors *errors);
       void statementSetParam(
          StatementHandle handle,
          int column,
@@ -501,27 +970,155 @@ class TsSqlStatementImpl: public QObject
       void statementFetchNext(
          TsSqlStatementImpl *object,
          StatementHandle handle);
+      void statementStopFetch(
+         TsSqlStatementImpl *object,
+         StatementHandle handle);
       void statementFetchSingleRow(
+         TsSqlStatementImpl *object,
          StatementHandle handle,
          TsSqlRow *result);
+      void statementFetchColumns(
+         TsSqlStatementImpl *object,
+         StatementHandle handle,
+         TsSqlColumnarBuffer *buffer,
+         int maxRows,
+         int *result);
+      void statementFetchRows(
+         TsSqlStatementImpl *object,
+         StatementHandle handle,
+         TsSqlRowBatch *rows,
+         int maxRows,
+         int *result);
       void statementInfo(
          TsSqlStatementImpl *object, 
          StatementHandle handle, 
          StatementInfo info,
          QVariant param,
          QVariant *result);
+      void statementLoadBlob(
+         TsSqlStatementImpl *object,
+         StatementHandle handle,
+         const TsSqlBlobId &id,
+         QByteArray *result,
+         bool *ok);
 
       void prepared();
       void executed();
+      void batchExecuted(int affectedRows, TsSqlBatchErrors errors);
       void fetchStarted();
       void fetched(TsSqlRow row);
+      void fetchedBatch(TsSqlRowBatch rows);
       void fetchFinished();
+      void cancelled();
+      void error(const QString &error);
+};
+
+class TsSqlBlobReaderImpl: public QObject
+{
+   Q_OBJECT
+   private:
+      BlobHandle m_handle;
+      int m_size, m_position;
+      QIODevice *m_device;
+      int m_chunkSize;
+      QByteArray m_buffer;
+      bool m_stop;
+      TsSqlNotifier m_notifier;
+      friend class TsSqlDatabaseWorker;
+   protected:
+      virtual void customEvent(QEvent *event);
+   public:
+      TsSqlBlobReaderImpl(
+         TsSqlDatabaseImpl &database,
+         TsSqlTransactionImpl &transaction,
+         const TsSqlBlobId &id);
+      ~TsSqlBlobReaderImpl();
+      int size();
+      int readWaiting(char *data, int maxSize);       // sync
+      QByteArray readAllWaiting();                    // sync
+      void read(QIODevice *device, int chunkSize);    // async
+      void stop();                                    // async
+   signals:
+      void createBlob(
+         TsSqlBlobReaderImpl *object,
+         DatabaseHandle database,
+         TransactionHandle transaction,
+         const TsSqlBlobId &id);
+      void destroyBlob(BlobHandle handle);
+      void blobRead(
+         TsSqlBlobReaderImpl *object,
+         BlobHandle handle,
+         char *data,
+         int maxSize,
+         int *result);
+      void blobReadAll(
+         TsSqlBlobReaderImpl *object,
+         BlobHandle handle,
+         QByteArray *result);
+      void blobReadNext(
+         TsSqlBlobReaderImpl *object,
+         BlobHandle handle);
+
+      void progress(qint64 bytesRead, qint64 size);
+      void finished();
+      void error(const QString &error);
+};
+
+class TsSqlBlobWriterImpl: public QObject
+{
+   Q_OBJECT
+   private:
+      BlobHandle m_handle;
+      qint64 m_size, m_deviceSize;
+      QIODevice *m_device;
+      QFile *m_file; // opened by writeFile()
+      int m_chunkSize;
+      QByteArray m_buffer;
+      bool m_stop;
+      TsSqlNotifier m_notifier;
+      void finishWrite();
+      friend class TsSqlDatabaseWorker;
+   protected:
+      virtual void customEvent(QEvent *event);
+   public:
+      TsSqlBlobWriterImpl(
+         TsSqlDatabaseImpl &database,
+         TsSqlTransactionImpl &transaction);
+      ~TsSqlBlobWriterImpl();
+      qint64 size();
+      void writeWaiting(const char *data, int size);          // sync
+      void write(QIODevice *device, int chunkSize);           // async
+      bool writeFile(const QString &fileName, int chunkSize); // async
+      void stop();                                            // async
+      TsSqlBlobId closeWaiting();                             // sync
+   signals:
+      void createBlob(
+         TsSqlBlobWriterImpl *object,
+         DatabaseHandle database,
+         TransactionHandle transaction);
+      void destroyBlob(BlobHandle handle);
+      void blobWrite(
+         TsSqlBlobWriterImpl *object,
+         BlobHandle handle,
+         const char *data,
+         int size);
+      void blobWriteNext(
+         TsSqlBlobWriterImpl *object,
+         BlobHandle handle);
+      void blobClose(
+         TsSqlBlobWriterImpl *object,
+         BlobHandle handle,
+         TsSqlBlobId *result);
+
+      void progress(qint64 bytesWritten, qint64 size);
+      void finished();
       void error(const QString &error);
 };
 
 Q_DECLARE_METATYPE(DatabaseHandle);
 Q_DECLARE_METATYPE(TransactionHandle);
 Q_DECLARE_METATYPE(StatementHandle);
+Q_DECLARE_METATYPE(BlobHandle);
 Q_DECLARE_METATYPE(DatabaseInfo);
 Q_DECLARE_METATYPE(StatementInfo);
 Q_DECLARE_METATYPE(QVariant);
@@ -263,7 +263,11 @@ void DatabaseTest::fillTest2()
 {
    if (m_dataCount)
    {
-      disconnect(&m_insertStatement, SIGNAL(executed()), this, SLOT(insertDataset()));
+      disconnect(
+         &m_insertStatement, 
+         SIGNAL(batchExecuted(int, TsSqlBatchErrors)), 
+         this, 
+         SLOT(insertDataset()));
       m_btnFill.setText("&Fill");
       m_dataCount = 0;
       m_transaction.commitRetainingWaiting();
@@ -273,7 +277,10 @@ void DatabaseTest::fillTest2()
       m_btnFill.setText("&Stop filling");
       m_database.openWaiting();
       m_transaction.startWaiting();
-      connect(&m_insertStatement, SIGNAL(executed()), SLOT(insertDataset()));
+      connect(
+         &m_insertStatement, 
+         SIGNAL(batchExecuted(int, TsSqlBatchErrors)), 
+         SLOT(insertDataset()));
 
       m_insertStatement.prepareWaiting(
             "insert into test2(id, field_blob, field_date, "
@@ -289,12 +296,14 @@ void DatabaseTest::fillTest2()
 
 void DatabaseTest::insertDataset()
 {
-   TsSqlRow params;
-   randomizeParams(params);
-   m_insertStatement.execute(params);
-   m_lDataCount.setText(QString("%1 datasets inserted").arg(++m_dataCount));
-   if ((m_dataCount % 1000) == 0)
+   if (m_dataCount)
       m_transaction.commitRetainingWaiting();
+   TsSqlRowBatch batch(1000);
+   for(int i = 0; i < batch.size(); ++i)
+      randomizeParams(batch[i]);
+   m_insertStatement.executeBatch(batch);
+   m_dataCount += batch.size();
+   m_lDataCount.setText(QString("%1 datasets inserted").arg(m_dataCount));
 }
 
 void DatabaseTest::testSync()
@@ -38,6 +38,9 @@
 #endif
 
 #include <limits>
+#ifdef IBPP_UNIX
+#include <dlfcn.h>
+#endif
 
 #ifdef IBPP_WINDOWS
 // New (optional) Registry Keys introduced by Firebird Server 1.5
@@ -271,6 +274,14 @@ GDS* GDS::Call()
 		IB_ENTRYPOINT(service_start);
 		IB_ENTRYPOINT(service_query);
 
+		// Optional entry-points, missing from older client libraries
+#ifdef IBPP_WINDOWS
+		m_cancel_operation = (proto_cancel_operation*)GetProcAddress(mHandle, "fb_cancel_operation");
+#endif
+#ifdef IBPP_UNIX
+		m_cancel_operation = (proto_cancel_operation*)dlsym(RTLD_DEFAULT, "fb_cancel_operation");
+#endif
+
 		mReady = true;
 	}
 
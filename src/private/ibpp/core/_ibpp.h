@@ -150,6 +150,15 @@ typedef ISC_STATUS  ISC_EXPORT proto_detach_database (ISC_STATUS *,
 typedef ISC_STATUS  ISC_EXPORT proto_drop_database (ISC_STATUS *,
 					  isc_db_handle *);
 
+// fb_cancel_operation() only exists in Firebird 2.5 and later client libraries,
+// it is looked up at run-time and may be missing (see GDS::Call()).
+#ifndef fb_cancel_raise
+#define fb_cancel_raise 3
+#endif
+typedef ISC_STATUS  ISC_EXPORT proto_cancel_operation (ISC_STATUS *,
+					  isc_db_handle *,
+					  ISC_USHORT);
+
 typedef ISC_STATUS  ISC_EXPORT proto_database_info (ISC_STATUS *,
 					  isc_db_handle *,
 					  short,
@@ -407,6 +416,7 @@ struct GDS
 	proto_detach_database*			m_detach_database;
 	proto_drop_database*			m_drop_database;
 	proto_database_info*			m_database_info;
+	proto_cancel_operation*			m_cancel_operation;	// Optional, may be 0
 	proto_dsql_execute_immediate*	m_dsql_execute_immediate;
 	proto_open_blob2*				m_open_blob2;
 	proto_create_blob2*				m_create_blob2;
@@ -462,6 +472,7 @@ struct GDS
 	{
 		mReady = false;
 		mGDSVersion = 0;
+		m_cancel_operation = 0;
 #ifdef IBPP_WINDOWS
 		mHandle = 0;
 #endif
@@ -878,6 +889,7 @@ public:
 	void Inactivate();
 	void Disconnect();
     void Drop();
+	bool Cancel();
 
 	IBPP::IDatabase* AddRef();
 	void Release();
@@ -945,17 +957,14 @@ class RowImpl : public IBPP::IRow
 	//	(((((((( OBJECT INTERNALS ))))))))
 
 private:
+	static const int SCANCOLUMNS;	// Rows with less columns are not indexed
+
 	int mRefCount;					// Reference counter
 
 	XSQLDA* mDescrArea;				// XSQLDA descriptor itself
-	std::vector<double> mNumerics;	// Temporary storage for Numerics
-	std::vector<float> mFloats;	 	// Temporary storage for Floats
-	std::vector<int64_t> mInt64s;	// Temporary storage for 64 bits
-	std::vector<int32_t> mInt32s;	// Temporary storage for 32 bits
-	std::vector<int16_t> mInt16s;	// Temporary storage for 16 bits
-	std::vector<char> mBools;		// Temporary storage for Bools
-	std::vector<std::string> mStrings;	// Temporary storage for Strings
+	std::vector<double> mData;		// Temporaries, null indicators and data of all columns
 	std::vector<bool> mUpdated;		// Which columns where updated (Set()) ?
+	std::vector<int> mNameIndex;	// Hash of column names (varnum) and aliases (-varnum)
 
 	int mDialect;					// Related database dialect
 	DatabaseImpl* mDatabase;		// Related Database (important for Blobs, ...)
@@ -963,12 +972,17 @@ private:
 
 	void SetValue(int, IITYPE, const void* value, int = 0);
 	void* GetValue(int, IITYPE, void* = 0);
+	const char* IndexedName(int entry, int& len);
+	void AddIndexedName(int entry);
+	int FindIndexedName(const char* name, int len);
+	int ScanNames(const char* name, int len);
 
 public:
 	void Free();
 	short AllocatedSize() { return mDescrArea->sqln; }
 	void Resize(int n);
 	void AllocVariables();
+	void IndexNames();			// Builds mNameIndex, done by the first ColumnNum()
 	bool MissingValues();		// Returns wether one of the mMissing[] is true
 	XSQLDA* Self() { return mDescrArea; }
 
@@ -996,6 +1010,7 @@ public:
 	void Set(int, const IBPP::DBKey&);
 	void Set(int, const IBPP::Blob&);
 	void Set(int, const IBPP::Array&);
+	void Set(int, const IBPP::ValueView&);
 
 	bool IsNull(int);
 	bool Get(int, bool&);
@@ -1013,6 +1028,7 @@ public:
 	bool Get(int, IBPP::DBKey&);
 	bool Get(int, IBPP::Blob&);
 	bool Get(int, IBPP::Array&);
+	bool Get(int, IBPP::ValueView&);
 
 	bool IsNull(const std::string&);
 	bool Get(const std::string&, bool&);
@@ -1071,6 +1087,7 @@ private:
 	bool mCursorOpened;			// dsql_set_cursor_name was called
 	IBPP::STT mType;			// Type de requte
 	std::string mSql;			// Last SQL statement prepared or executed
+	std::vector<IBPP::Array> mColumnArrays;	// Described on first use
 
 	// Internal Methods
 	void CursorFree();
@@ -1119,6 +1136,7 @@ public:
 	void Set(int, const IBPP::DBKey&);
 	void Set(int, const IBPP::Blob&);
 	void Set(int, const IBPP::Array&);
+	void Set(int, const IBPP::ValueView&);
 
 	bool IsNull(int);
 	bool Get(int, bool*);
@@ -1142,6 +1160,7 @@ public:
 	bool Get(int, IBPP::DBKey&);
 	bool Get(int, IBPP::Blob&);
 	bool Get(int, IBPP::Array&);
+	bool Get(int, IBPP::ValueView&);
 
 	bool IsNull(const std::string&);
 	bool Get(const std::string&, bool*);
@@ -1176,6 +1195,7 @@ public:
 	int ColumnSize(int);
 	int ColumnScale(int);
 	int Columns();
+	IBPP::Array ColumnArray(int);
 
 	IBPP::SDT ParameterType(int);
 	int ParameterSubtype(int);
@@ -1231,6 +1251,8 @@ public:
 	int Read(void*, int size);
 	void Write(const void*, int size);
 	void Info(int* Size, int* Largest, int* Segments);
+	void SetId(const IBPP::ValueView& id);
+	void GetId(IBPP::ValueView& id);
 
 	void Save(const std::string& data);
 	void Load(std::string& data);
@@ -41,6 +41,135 @@
 
 using namespace ibpp_internals;
 
+namespace
+{
+	// Conversions between the elements packed in the array buffer and the
+	// caller's buffer. They are plain loops over typed pointers, which the
+	// compilers turn into vector instructions.
+
+	template<typename S, typename D>
+	void CopyElements(const S* src, D* dst, int count)
+	{
+		for (int i = 0; i < count; i++)
+			dst[i] = D(src[i]);
+	}
+
+	template<typename S>
+	void BoolElements(const S* src, bool* dst, int count)
+	{
+		for (int i = 0; i < count; i++)
+			dst[i] = src[i] != 0;
+	}
+
+	template<typename S, typename D>
+	void IntegerElements(const S* src, D* dst, int count,
+		int64_t low, int64_t high, const char* where)
+	{
+		if (sizeof(S) > sizeof(D))
+		{
+			// Checked in a pass of its own, which keeps both loops branch-free
+			bool inrange = true;
+			for (int i = 0; i < count; i++)
+				inrange &= (src[i] >= low) & (src[i] <= high);
+			if (! inrange)
+				throw LogicExceptionImpl(where, _("Out of range numeric conversion !"));
+		}
+		CopyElements(src, dst, count);
+	}
+
+	template<typename S, typename D>
+	void ScaleElements(const S* src, D* dst, int count, double divisor)
+	{
+		for (int i = 0; i < count; i++)
+			dst[i] = D(src[i] / divisor);
+	}
+
+	template<typename S, typename D>
+	void RoundElements(const S* src, D* dst, int count, double multiplier)
+	{
+		for (int i = 0; i < count; i++)
+			dst[i] = D(floor(src[i] * multiplier + 0.5));
+	}
+
+	// Integer elements, scaled for floating point types only
+	template<typename S>
+	void ReadIntegers(IBPP::ADT adtype, const S* src, void* data, int count, int scale)
+	{
+		switch (adtype)
+		{
+			case IBPP::adBool :
+				BoolElements(src, (bool*)data, count);
+				break;
+			case IBPP::adInt16 :
+				IntegerElements(src, (int16_t*)data, count,
+					consts::min16, consts::max16, "Array::ReadTo");
+				break;
+			case IBPP::adInt32 :
+				IntegerElements(src, (int32_t*)data, count,
+					consts::min32, consts::max32, "Array::ReadTo");
+				break;
+			case IBPP::adInt64 :
+				CopyElements(src, (int64_t*)data, count);
+				break;
+			case IBPP::adFloat :
+				// This integer is a NUMERIC(x,y), scale it !
+				ScaleElements(src, (float*)data, count, consts::dscales[-scale]);
+				break;
+			case IBPP::adDouble :
+				ScaleElements(src, (double*)data, count, consts::dscales[-scale]);
+				break;
+			default :
+				throw LogicExceptionImpl("Array::ReadTo", _("Incompatible types."));
+		}
+	}
+
+	// low and high are the range of D
+	template<typename D>
+	void WriteIntegers(IBPP::ADT adtype, const void* data, D* dst, int count, int scale,
+		int64_t low, int64_t high)
+	{
+		switch (adtype)
+		{
+			case IBPP::adBool :
+				CopyElements((const bool*)data, dst, count);
+				break;
+			case IBPP::adInt16 :
+				IntegerElements((const int16_t*)data, dst, count, low, high, "Array::WriteFrom");
+				break;
+			case IBPP::adInt32 :
+				IntegerElements((const int32_t*)data, dst, count, low, high, "Array::WriteFrom");
+				break;
+			case IBPP::adInt64 :
+				IntegerElements((const int64_t*)data, dst, count, low, high, "Array::WriteFrom");
+				break;
+			case IBPP::adFloat :
+				// This integer is a NUMERIC(x,y), scale it !
+				RoundElements((const float*)data, dst, count, consts::dscales[-scale]);
+				break;
+			case IBPP::adDouble :
+				RoundElements((const double*)data, dst, count, consts::dscales[-scale]);
+				break;
+			default :
+				throw LogicExceptionImpl("Array::WriteFrom", _("Incompatible types."));
+		}
+	}
+
+	// True if the elements are stored exactly as the caller wants them, so
+	// they go from and to the caller's buffer without any conversion
+	bool NativeElements(const ISC_ARRAY_DESC& desc, IBPP::ADT adtype)
+	{
+		switch (desc.array_desc_dtype)
+		{
+			case blr_short :	return adtype == IBPP::adInt16;
+			case blr_long :		return adtype == IBPP::adInt32;
+			case blr_int64 :	return adtype == IBPP::adInt64;
+			case blr_float :	return adtype == IBPP::adFloat && desc.array_desc_scale == 0;
+			case blr_double :	return adtype == IBPP::adDouble && desc.array_desc_scale == 0;
+			default :			return false;
+		}
+	}
+}
+
 //	(((((((( OBJECT INTERFACE IMPLEMENTATION ))))))))
 
 void ArrayImpl::Describe(const std::string& table, const std::string& column)
@@ -203,14 +332,17 @@ void ArrayImpl::ReadTo(IBPP::ADT adtype, void* data, int datacount)
 	if (datacount != mElemCount)
 		throw LogicExceptionImpl("Array::ReadTo", _("Wrong count of array elements"));
 
+	bool native = NativeElements(mDesc, adtype);
 	IBS status;
 	ISC_LONG lenbuf = mBufferSize;
 	(*gds.Call()->m_array_get_slice)(status.Self(), mDatabase->GetHandlePtr(),
-		mTransaction->GetHandlePtr(), &mId, &mDesc, mBuffer, &lenbuf);
+		mTransaction->GetHandlePtr(), &mId, &mDesc, native ? data : mBuffer, &lenbuf);
 	if (status.Errors())
 		throw SQLExceptionImpl(status, "Array::ReadTo", _("isc_array_get_slice failed."));
 	if (lenbuf != mBufferSize)
 		throw SQLExceptionImpl(status, "Array::ReadTo", _("Internal buffer size discrepancy."));
+	if (native)
+		return;
 
 	// Now, convert the types and copy values to the user array...
 	int len;
@@ -272,234 +404,34 @@ void ArrayImpl::ReadTo(IBPP::ADT adtype, void* data, int datacount)
 			break;
 
 		case blr_short :
-			if (adtype == IBPP::adBool)
-			{
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(bool*)dst = (*(short*)src != 0) ? true : false;
-					src += mElemSize;
-					dst += sizeof(bool);
-				}
-			}
-			else if (adtype == IBPP::adInt16)
-			{
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(short*)dst = *(short*)src;
-					src += mElemSize;
-					dst += sizeof(short);
-				}
-			}
-			else if (adtype == IBPP::adInt32)
-			{
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(int*)dst = (int)*(short*)src;
-					src += mElemSize;
-					dst += sizeof(int);
-				}
-			}
-			else if (adtype == IBPP::adInt64)
-			{
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(int64_t*)dst = (int64_t)*(short*)src;
-					src += mElemSize;
-					dst += sizeof(int64_t);
-				}
-			}
-			else if (adtype == IBPP::adFloat)
-			{
-				// This SQL_SHORT is a NUMERIC(x,y), scale it !
-				double divisor = consts::dscales[-mDesc.array_desc_scale];
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(float*)dst = (float)(*(short*)src / divisor);
-					src += mElemSize;
-					dst += sizeof(float);
-				}
-			}
-			else if (adtype == IBPP::adDouble)
-			{
-				// This SQL_SHORT is a NUMERIC(x,y), scale it !
-				double divisor = consts::dscales[-mDesc.array_desc_scale];
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(double*)dst = (double)(*(short*)src / divisor);
-					src += mElemSize;
-					dst += sizeof(double);
-				}
-			}
-			else throw LogicExceptionImpl("Array::ReadTo", _("Incompatible types."));
+			ReadIntegers(adtype, (const int16_t*)src, data, mElemCount,
+				mDesc.array_desc_scale);
 			break;
 
 		case blr_long :
-			if (adtype == IBPP::adBool)
-			{
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(bool*)dst = (*(long*)src != 0) ? true : false;
-					src += mElemSize;
-					dst += sizeof(bool);
-				}
-			}
-			else if (adtype == IBPP::adInt16)
-			{
-				for (int i = 0; i < mElemCount; i++)
-				{
-					if (*(long*)src < consts::min16 || *(long*)src > consts::max16)
-						throw LogicExceptionImpl("Array::ReadTo",
-							_("Out of range numeric conversion !"));
-					*(short*)dst = short(*(long*)src);
-					src += mElemSize;
-					dst += sizeof(short);
-				}
-			}
-			else if (adtype == IBPP::adInt32)
-			{
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(long*)dst = *(long*)src;
-					src += mElemSize;
-					dst += sizeof(long);
-				}
-			}
-			else if (adtype == IBPP::adInt64)
-			{
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(int64_t*)dst = (int64_t)*(long*)src;
-					src += mElemSize;
-					dst += sizeof(int64_t);
-				}
-			}
-			else if (adtype == IBPP::adFloat)
-			{
-				// This SQL_SHORT is a NUMERIC(x,y), scale it !
-				double divisor = consts::dscales[-mDesc.array_desc_scale];
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(float*)dst = (float)(*(long*)src / divisor);
-					src += mElemSize;
-					dst += sizeof(float);
-				}
-			}
-			else if (adtype == IBPP::adDouble)
-			{
-				// This SQL_SHORT is a NUMERIC(x,y), scale it !
-				double divisor = consts::dscales[-mDesc.array_desc_scale];
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(double*)dst = (double)(*(long*)src / divisor);
-					src += mElemSize;
-					dst += sizeof(double);
-				}
-			}
-			else throw LogicExceptionImpl("Array::ReadTo", _("Incompatible types."));
+			ReadIntegers(adtype, (const int32_t*)src, data, mElemCount,
+				mDesc.array_desc_scale);
 			break;
 
 		case blr_int64 :
-			if (adtype == IBPP::adBool)
-			{
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(bool*)dst = (*(int64_t*)src != 0) ? true : false;
-					src += mElemSize;
-					dst += sizeof(bool);
-				}
-			}
-			else if (adtype == IBPP::adInt16)
-			{
-				for (int i = 0; i < mElemCount; i++)
-				{
-					if (*(int64_t*)src < consts::min16 || *(int64_t*)src > consts::max16)
-						throw LogicExceptionImpl("Array::ReadTo",
-							_("Out of range numeric conversion !"));
-					*(short*)dst = short(*(int64_t*)src);
-					src += mElemSize;
-					dst += sizeof(short);
-				}
-			}
-			else if (adtype == IBPP::adInt32)
-			{
-				for (int i = 0; i < mElemCount; i++)
-				{
-					if (*(int64_t*)src < consts::min32 || *(int64_t*)src > consts::max32)
-						throw LogicExceptionImpl("Array::ReadTo",
-							_("Out of range numeric conversion !"));
-					*(long*)dst = (long)*(int64_t*)src;
-					src += mElemSize;
-					dst += sizeof(long);
-				}
-			}
-			else if (adtype == IBPP::adInt64)
-			{
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(int64_t*)dst = *(int64_t*)src;
-					src += mElemSize;
-					dst += sizeof(int64_t);
-				}
-			}
-			else if (adtype == IBPP::adFloat)
-			{
-				// This SQL_SHORT is a NUMERIC(x,y), scale it !
-				double divisor = consts::dscales[-mDesc.array_desc_scale];
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(float*)dst = (float)(*(int64_t*)src / divisor);
-					src += mElemSize;
-					dst += sizeof(float);
-				}
-			}
-			else if (adtype == IBPP::adDouble)
-			{
-				// This SQL_SHORT is a NUMERIC(x,y), scale it !
-				double divisor = consts::dscales[-mDesc.array_desc_scale];
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(double*)dst = (double)(*(int64_t*)src / divisor);
-					src += mElemSize;
-					dst += sizeof(double);
-				}
-			}
-			else throw LogicExceptionImpl("Array::ReadTo", _("Incompatible types."));
+			ReadIntegers(adtype, (const int64_t*)src, data, mElemCount,
+				mDesc.array_desc_scale);
 			break;
 
 		case blr_float :
-			if (adtype != IBPP::adFloat || mDesc.array_desc_scale != 0)
-				throw LogicExceptionImpl("Array::ReadTo", _("Incompatible types."));
-			for (int i = 0; i < mElemCount; i++)
-			{
-				*(float*)dst = *(float*)src;
-				src += mElemSize;
-				dst += sizeof(float);
-			}
+			// adFloat is native, widening to adDouble is the only conversion
+			if (adtype != IBPP::adDouble) throw LogicExceptionImpl("Array::ReadTo",
+										_("Incompatible types."));
+			ScaleElements((const float*)src, (double*)data, mElemCount,
+				consts::dscales[-mDesc.array_desc_scale]);
 			break;
 
 		case blr_double :
 			if (adtype != IBPP::adDouble) throw LogicExceptionImpl("Array::ReadTo",
 										_("Incompatible types."));
-			if (mDesc.array_desc_scale != 0)
-			{
-				// Round to scale of NUMERIC(x,y)
-				double divisor = consts::dscales[-mDesc.array_desc_scale];
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(double*)dst =	(double)(*(double*)src / divisor);
-					src += mElemSize;
-					dst += sizeof(double);
-				}
-			}
-			else
-			{
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(double*)dst = *(double*)src;
-					src += mElemSize;
-					dst += sizeof(double);
-				}
-			}
+			// Round to scale of NUMERIC(x,y)
+			ScaleElements((const double*)src, (double*)data, mElemCount,
+				consts::dscales[-mDesc.array_desc_scale]);
 			break;
 
 		case blr_timestamp :
@@ -551,12 +483,14 @@ void ArrayImpl::WriteFrom(IBPP::ADT adtype, const void* data, int datacount)
 	if (datacount != mElemCount)
 		throw LogicExceptionImpl("Array::ReadTo", _("Wrong count of array elements"));
 
+	bool native = NativeElements(mDesc, adtype);
+
 	// Read user data and convert types to the mBuffer
 	int len;
 	char* src = (char*)data;
 	char* dst = (char*)mBuffer;
 
-	switch (mDesc.array_desc_dtype)
+	if (! native) switch (mDesc.array_desc_dtype)
 	{
 		case blr_text :
 			if (adtype == IBPP::adString)
@@ -612,242 +546,38 @@ void ArrayImpl::WriteFrom(IBPP::ADT adtype, const void* data, int datacount)
 			break;
 
 		case blr_short :
-			if (adtype == IBPP::adBool)
-			{
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(short*)dst = short(*(bool*)src ? 1 : 0);
-					src += sizeof(bool);
-					dst += mElemSize;
-				}
-			}
-			else if (adtype == IBPP::adInt16)
-			{
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(short*)dst = *(short*)src;
-					src += sizeof(short);
-					dst += mElemSize;
-				}
-			}
-			else if (adtype == IBPP::adInt32)
-			{
-				for (int i = 0; i < mElemCount; i++)
-				{
-					if (*(long*)src < consts::min16 || *(long*)src > consts::max16)
-						throw LogicExceptionImpl("Array::WriteFrom",
-							_("Out of range numeric conversion !"));
-					*(short*)dst = (short)*(int*)src;
-					src += sizeof(int);
-					dst += mElemSize;
-				}
-			}
-			else if (adtype == IBPP::adInt64)
-			{
-				for (int i = 0; i < mElemCount; i++)
-				{
-					if (*(int64_t*)src < consts::min16 || *(int64_t*)src > consts::max16)
-						throw LogicExceptionImpl("Array::WriteFrom",
-							_("Out of range numeric conversion !"));
-					*(short*)dst = (short)*(int64_t*)src;
-					src += sizeof(int64_t);
-					dst += mElemSize;
-				}
-			}
-			else if (adtype == IBPP::adFloat)
-			{
-				// This SQL_SHORT is a NUMERIC(x,y), scale it !
-				double multiplier = consts::dscales[-mDesc.array_desc_scale];
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(short*)dst =
-						(short)floor(*(float*)src * multiplier + 0.5);
-					src += sizeof(float);
-					dst += mElemSize;
-				}
-			}
-			else if (adtype == IBPP::adDouble)
-			{
-				// This SQL_SHORT is a NUMERIC(x,y), scale it !
-				double multiplier = consts::dscales[-mDesc.array_desc_scale];
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(short*)dst =
-						(short)floor(*(double*)src * multiplier + 0.5);
-					src += sizeof(double);
-					dst += mElemSize;
-				}
-			}
-			else throw LogicExceptionImpl("Array::WriteFrom", _("Incompatible types."));
+			WriteIntegers(adtype, data, (int16_t*)dst, mElemCount,
+				mDesc.array_desc_scale, consts::min16, consts::max16);
 			break;
 
 		case blr_long :
-			if (adtype == IBPP::adBool)
-			{
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(long*)dst = *(bool*)src ? 1 : 0;
-					src += sizeof(bool);
-					dst += mElemSize;
-				}
-			}
-			else if (adtype == IBPP::adInt16)
-			{
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(long*)dst = *(short*)src;
-					src += sizeof(short);
-					dst += mElemSize;
-				}
-			}
-			else if (adtype == IBPP::adInt32)
-			{
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(long*)dst = *(long*)src;
-					src += sizeof(long);
-					dst += mElemSize;
-				}
-			}
-			else if (adtype == IBPP::adInt64)
-			{
-				for (int i = 0; i < mElemCount; i++)
-				{
-					if (*(int64_t*)src < consts::min32 || *(int64_t*)src > consts::max32)
-						throw LogicExceptionImpl("Array::WriteFrom",
-							_("Out of range numeric conversion !"));
-					*(long*)dst = (long)*(int64_t*)src;
-					src += sizeof(int64_t);
-					dst += mElemSize;
-				}
-			}
-			else if (adtype == IBPP::adFloat)
-			{
-				// This SQL_INT is a NUMERIC(x,y), scale it !
-				double multiplier = consts::dscales[-mDesc.array_desc_scale];
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(long*)dst =
-						(long)floor(*(float*)src * multiplier + 0.5);
-					src += sizeof(float);
-					dst += mElemSize;
-				}
-			}
-			else if (adtype == IBPP::adDouble)
-			{
-				// This SQL_INT is a NUMERIC(x,y), scale it !
-				double multiplier = consts::dscales[-mDesc.array_desc_scale];
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(long*)dst =
-						(long)floor(*(double*)src * multiplier + 0.5);
-					src += sizeof(double);
-					dst += mElemSize;
-				}
-			}
-			else throw LogicExceptionImpl("Array::WriteFrom", _("Incompatible types."));
+			WriteIntegers(adtype, data, (int32_t*)dst, mElemCount,
+				mDesc.array_desc_scale, consts::min32, consts::max32);
 			break;
 
 		case blr_int64 :
-			if (adtype == IBPP::adBool)
-			{
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(int64_t*)dst = *(bool*)src ? 1 : 0;
-					src += sizeof(bool);
-					dst += mElemSize;
-				}
-			}
-			else if (adtype == IBPP::adInt16)
-			{
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(int64_t*)dst = *(short*)src;
-					src += sizeof(short);
-					dst += mElemSize;
-				}
-			}
-			else if (adtype == IBPP::adInt32)
-			{
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(int64_t*)dst = *(long*)src;
-					src += sizeof(long);
-					dst += mElemSize;
-				}
-			}
-			else if (adtype == IBPP::adInt64)
-			{
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(int64_t*)dst = *(int64_t*)src;
-					src += sizeof(int64_t);
-					dst += mElemSize;
-				}
-			}
-			else if (adtype == IBPP::adFloat)
-			{
-				// This SQL_INT is a NUMERIC(x,y), scale it !
-				double multiplier = consts::dscales[-mDesc.array_desc_scale];
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(int64_t*)dst =
-						(int64_t)floor(*(float*)src * multiplier + 0.5);
-					src += sizeof(float);
-					dst += mElemSize;
-				}
-			}
-			else if (adtype == IBPP::adDouble)
-			{
-				// This SQL_INT is a NUMERIC(x,y), scale it !
-				double multiplier = consts::dscales[-mDesc.array_desc_scale];
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(int64_t*)dst =
-						(int64_t)floor(*(double*)src * multiplier + 0.5);
-					src += sizeof(double);
-					dst += mElemSize;
-				}
-			}
-			else
-				throw LogicExceptionImpl("Array::WriteFrom",
-					_("Incompatible types (blr_int64 and ADT %d)."), (int)adtype);
+			// Never narrowed, so the range is not used
+			WriteIntegers(adtype, data, (int64_t*)dst, mElemCount,
+				mDesc.array_desc_scale, 0, 0);
 			break;
 
 		case blr_float :
-			if (adtype != IBPP::adFloat || mDesc.array_desc_scale != 0)
-				throw LogicExceptionImpl("Array::WriteFrom", _("Incompatible types."));
-			for (int i = 0; i < mElemCount; i++)
-			{
-				*(float*)dst = *(float*)src;
-				src += sizeof(float);
-				dst += mElemSize;
-			}
+			// adFloat is native, narrowing from adDouble is the only conversion
+			if (adtype != IBPP::adDouble) throw LogicExceptionImpl("Array::WriteFrom",
+										_("Incompatible types."));
+			CopyElements((const double*)src, (float*)dst, mElemCount);
 			break;
 
 		case blr_double :
 			if (adtype != IBPP::adDouble) throw LogicExceptionImpl("Array::WriteFrom",
 										_("Incompatible types."));
-			if (mDesc.array_desc_scale != 0)
 			{
 				// Round to scale of NUMERIC(x,y)
 				double multiplier = consts::dscales[-mDesc.array_desc_scale];
+				const double* values = (const double*)src;
+				double* elements = (double*)dst;
 				for (int i = 0; i < mElemCount; i++)
-				{
-					*(double*)dst =
-						floor(*(double*)src * multiplier + 0.5) / multiplier;
-					src += sizeof(double);
-					dst += mElemSize;
-				}
-			}
-			else
-			{
-				for (int i = 0; i < mElemCount; i++)
-				{
-					*(double*)dst = *(double*)src;
-					src += sizeof(double);
-					dst += mElemSize;
-				}
+					elements[i] = floor(values[i] * multiplier + 0.5) / multiplier;
 			}
 			break;
 
@@ -891,7 +621,8 @@ void ArrayImpl::WriteFrom(IBPP::ADT adtype, const void* data, int datacount)
 	IBS status;
 	ISC_LONG lenbuf = mBufferSize;
 	(*gds.Call()->m_array_put_slice)(status.Self(), mDatabase->GetHandlePtr(),
-		mTransaction->GetHandlePtr(), &mId, &mDesc, mBuffer, &lenbuf);
+		mTransaction->GetHandlePtr(), &mId, &mDesc,
+			native ? const_cast<void*>(data) : mBuffer, &lenbuf);
 	if (status.Errors())
 		throw SQLExceptionImpl(status, "Array::WriteFrom", _("isc_array_put_slice failed."));
 	if (lenbuf != mBufferSize)
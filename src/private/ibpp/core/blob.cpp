@@ -183,7 +183,7 @@ void BlobImpl::Save(const std::string& data)
 	size_t len = data.size();
 	while (len != 0)
 	{
-		size_t blklen = (len < 32*1024-1) ? len : 32*1024-1;
+		size_t blklen = (len < 64*1024-1) ? len : 64*1024-1;
 		status.Reset();
 		(*gds.Call()->m_put_segment)(status.Self(), &mHandle,
 			(unsigned short)blklen, const_cast<char*>(data.data()+pos));
@@ -219,14 +219,18 @@ void BlobImpl::Load(std::string& data)
 		throw SQLExceptionImpl(status, "Blob::Load", _("isc_open_blob2 failed."));
 	mWriteMode = false;
 
-	size_t blklen = 32*1024-1;
-	data.resize(blklen);
+	// The data is read into a buffer of the blob's total length, which
+	// never needs to grow
+	int total = 0;
+	Info(&total, 0, 0);
+	data.resize(total);
 
-	size_t size = 0;
 	size_t pos = 0;
-	for (;;)
+	while (pos < data.size())
 	{
 		status.Reset();
+		size_t blklen = data.size() - pos;
+		if (blklen > 64*1024-1) blklen = 64*1024-1;
 		unsigned short bytesread;
 		int result = (*gds.Call()->m_get_segment)(status.Self(), &mHandle,
 						&bytesread, (unsigned short)blklen,
@@ -236,10 +240,8 @@ void BlobImpl::Load(std::string& data)
 			throw SQLExceptionImpl(status, "Blob::Load", _("isc_get_segment failed."));
 
 		pos += bytesread;
-		size += bytesread;
-		data.resize(size + blklen);
 	}
-	data.resize(size);
+	data.resize(pos);
 	
 	status.Reset();
 	(*gds.Call()->m_close_blob)(status.Self(), &mHandle);
@@ -300,6 +302,15 @@ void BlobImpl::SetId(ISC_QUAD* quad)
 	mIdAssigned = true;
 }
 
+void BlobImpl::SetId(const IBPP::ValueView& id)
+{
+	if ((id.type != IBPP::sdBlob && id.type != IBPP::sdArray)
+		|| id.length != sizeof(ISC_QUAD))
+		throw LogicExceptionImpl("BlobImpl::SetId", _("The value is no blob id."));
+
+	SetId((ISC_QUAD*)id.data);
+}
+
 void BlobImpl::GetId(ISC_QUAD* quad)
 {
 	if (mHandle != 0)
@@ -312,6 +323,19 @@ void BlobImpl::GetId(ISC_QUAD* quad)
 	memcpy(quad, &mId, sizeof(mId));
 }
 
+void BlobImpl::GetId(IBPP::ValueView& id)
+{
+	if (mHandle != 0)
+		throw LogicExceptionImpl("BlobImpl::GetId", _("Can't get Id on an opened BlobImpl."));
+	if (! mWriteMode)
+		throw LogicExceptionImpl("BlobImpl::GetId", _("Can only get Id of a newly created Blob."));
+
+	id.type = IBPP::sdBlob;
+	id.scale = 0;
+	id.data = (const char*)&mId;
+	id.length = sizeof(mId);
+}
+
 void BlobImpl::AttachDatabaseImpl(DatabaseImpl* database)
 {
 	if (database == 0) throw LogicExceptionImpl("Blob::AttachDatabase",
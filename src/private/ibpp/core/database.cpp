@@ -227,6 +227,19 @@ void DatabaseImpl::Drop()
     mHandle = 0;
 }
 
+bool DatabaseImpl::Cancel()
+{
+	if (mHandle == 0) return false;	// Nothing running anyway
+
+	GDS* g = gds.Call();
+	if (g->m_cancel_operation == 0) return false;
+
+	// Errors are ignored : the typical one is that there is nothing to cancel
+	IBS status;
+	(*g->m_cancel_operation)(status.Self(), &mHandle, fb_cancel_raise);
+	return status.Errors() ? false : true;
+}
+
 void DatabaseImpl::Info(int* ODSMajor, int* ODSMinor,
 	int* PageSize, int* Pages, int* Buffers, int* Sweep,
 	bool* Sync, bool* Reserve)
@@ -366,6 +366,30 @@ namespace IBPP
 		~DBKey() { }
 	};
 
+	/* Class ValueView gives read-only access to a fetched column value right
+	 * where the engine delivered it, without copying or converting it. It is
+	 * only valid until the next Fetch() of its statement. The data is in the
+	 * engine's format: strings as their characters (CHAR columns padded),
+	 * numbers in native byte order and unscaled (see scale), dates as days
+	 * since 17.11.1858, times in 1/10000 seconds, timestamps as a date
+	 * followed by a time, blobs and arrays as their 8 byte id.
+	 * Passed to Set(), a ValueView in the parameter's own type and scale is
+	 * copied as it is, other types are converted like by the typed Set().
+	 * Blob and array ids are copied whatever the parameter's scale, which
+	 * holds the character set of text blobs. */
+
+	class ValueView
+	{
+	public:
+		SDT type;
+		int scale;
+		const char* data;	// 0 when the value is SQL NULL
+		int length;
+
+		bool IsNull() const	{ return data == 0; }
+		ValueView() : type(sdString), scale(0), data(0), length(0) { }
+	};
+
 	/* Class User wraps all the information about a user that the engine can manage. */
 
 	class User
@@ -471,6 +495,8 @@ namespace IBPP
 		virtual int Read(void*, int size) = 0;
 		virtual void Write(const void*, int size) = 0;
 		virtual void Info(int* Size, int* Largest, int* Segments) = 0;
+		virtual void SetId(const ValueView& id) = 0;	// as fetched from a blob column
+		virtual void GetId(ValueView& id) = 0;		// of a created and closed blob
 	
 		virtual void Save(const std::string& data) = 0;
 		virtual void Load(std::string& data) = 0;
@@ -588,6 +614,9 @@ namespace IBPP
 		virtual void Inactivate() = 0;
 		virtual void Disconnect() = 0;
 		virtual void Drop() = 0;
+		// Cancels the operation running on this connection, from any thread.
+		// Returns false if the client library can't cancel (before FB 2.5).
+		virtual bool Cancel() = 0;
 
 		virtual IDatabase* AddRef() = 0;
 		virtual void Release() = 0;
@@ -648,6 +677,7 @@ namespace IBPP
 		virtual void Set(int, const DBKey&) = 0;
 		virtual void Set(int, const Blob&) = 0;
 		virtual void Set(int, const Array&) = 0;
+		virtual void Set(int, const ValueView&) = 0;
 
 		virtual bool IsNull(int) = 0;
 		virtual bool Get(int, bool&) = 0;
@@ -664,6 +694,7 @@ namespace IBPP
 		virtual bool Get(int, DBKey&) = 0;
 		virtual bool Get(int, Blob&) = 0;
 		virtual bool Get(int, Array&) = 0;
+		virtual bool Get(int, ValueView&) = 0;
 
 		virtual bool IsNull(const std::string&) = 0;
 		virtual bool Get(const std::string&, bool&) = 0;
@@ -743,6 +774,7 @@ namespace IBPP
 		virtual void Set(int, const DBKey& value) = 0;
 		virtual void Set(int, const Blob& value) = 0;
 		virtual void Set(int, const Array& value) = 0;
+		virtual void Set(int, const ValueView& value) = 0;
 
 		virtual bool IsNull(int) = 0;
 		virtual bool Get(int, bool&) = 0;
@@ -759,6 +791,7 @@ namespace IBPP
 		virtual bool Get(int, DBKey& value) = 0;
 		virtual bool Get(int, Blob& value) = 0;
 		virtual bool Get(int, Array& value) = 0;
+		virtual bool Get(int, ValueView& value) = 0;
 
 		virtual bool IsNull(const std::string&) = 0;
 		virtual bool Get(const std::string&, bool&) = 0;
@@ -785,6 +818,8 @@ namespace IBPP
 		virtual int ColumnSize(int) = 0;
 		virtual int ColumnScale(int) = 0;
 		virtual int Columns() = 0;
+		// Array described for an array column, looked up once per Prepare()
+		virtual Array ColumnArray(int) = 0;
 
 		virtual SDT ParameterType(int) = 0;
 		virtual int ParameterSubtype(int) = 0;
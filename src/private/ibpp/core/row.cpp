@@ -42,6 +42,8 @@
 
 using namespace ibpp_internals;
 
+const int RowImpl::SCANCOLUMNS = 32;
+
 //	(((((((( OBJECT INTERFACE IMPLEMENTATION ))))))))
 
 void RowImpl::SetNull(int param)
@@ -226,6 +228,122 @@ void RowImpl::Set(int param, const IBPP::DBKey& key)
 	mUpdated[param-1] = true;
 }
 
+void RowImpl::Set(int param, const IBPP::ValueView& value)
+{
+	if (mDescrArea == 0)
+		throw LogicExceptionImpl("Row::Set[ValueView]", _("The row is not initialized."));
+	if (param < 1 || param > mDescrArea->sqld)
+		throw LogicExceptionImpl("Row::Set[ValueView]", _("Variable index out of range."));
+
+	if (value.IsNull())
+	{
+		SetNull(param);
+		return;
+	}
+
+	XSQLVAR* var = &(mDescrArea->sqlvar[param-1]);
+	IBPP::SDT type = ColumnType(param);
+	if (type == IBPP::sdString && value.type == IBPP::sdString)
+	{
+		// Copied straight into the buffer sized at Prepare(), truncated
+		// to the parameter's length
+		int16_t len = (int16_t)(value.length > var->sqllen ? var->sqllen : value.length);
+		if ((var->sqltype & ~1) == SQL_VARYING)
+		{
+			*(int16_t*)var->sqldata = len;
+			memcpy(var->sqldata+2, value.data, len);
+		}
+		else
+		{
+			memcpy(var->sqldata, value.data, len);
+			memset(var->sqldata+len, ' ', var->sqllen-len);
+		}
+		if (var->sqltype & 1) *var->sqlind = 0;
+	}
+	// Blob and array ids are copied whatever the scale, which holds the
+	// character set of text blobs
+	else if (type == value.type && value.length == var->sqllen
+		&& (value.scale == var->sqlscale
+			|| type == IBPP::sdBlob || type == IBPP::sdArray))
+	{
+		memcpy(var->sqldata, value.data, var->sqllen);
+		if (var->sqltype & 1) *var->sqlind = 0;
+	}
+	else switch (value.type)
+	{
+		case IBPP::sdString :
+			{
+				std::string svalue(value.data, value.length);
+				SetValue(param, ivString, &svalue);
+			}
+			break;
+		case IBPP::sdSmallint :
+		case IBPP::sdInteger :
+		case IBPP::sdLargeint :
+			{
+				int64_t ivalue;
+				if (value.length == 2) { int16_t v; memcpy(&v, value.data, 2); ivalue = v; }
+				else if (value.length == 4) { int32_t v; memcpy(&v, value.data, 4); ivalue = v; }
+				else if (value.length == 8) memcpy(&ivalue, value.data, 8);
+				else throw LogicExceptionImpl("Row::Set[ValueView]", _("Unexpected value length."));
+				if (value.scale == 0) SetValue(param, ivInt64, &ivalue);
+				else
+				{
+					double dvalue = (double)ivalue / consts::dscales[-value.scale];
+					SetValue(param, ivDouble, &dvalue);
+				}
+			}
+			break;
+		case IBPP::sdFloat :
+			{
+				float fvalue;
+				memcpy(&fvalue, value.data, sizeof(float));
+				SetValue(param, ivFloat, &fvalue);
+			}
+			break;
+		case IBPP::sdDouble :
+			{
+				double dvalue;
+				memcpy(&dvalue, value.data, sizeof(double));
+				SetValue(param, ivDouble, &dvalue);
+			}
+			break;
+		// Through the typed setters, which convert DATE to the
+		// timestamp of dialect 1
+		case IBPP::sdDate :
+			{
+				ISC_DATE isc_dt;
+				memcpy(&isc_dt, value.data, sizeof(ISC_DATE));
+				IBPP::Date dt;
+				decodeDate(dt, isc_dt);
+				Set(param, dt);
+			}
+			break;
+		case IBPP::sdTime :
+			{
+				ISC_TIME isc_tm;
+				memcpy(&isc_tm, value.data, sizeof(ISC_TIME));
+				IBPP::Time tm;
+				decodeTime(tm, isc_tm);
+				Set(param, tm);
+			}
+			break;
+		case IBPP::sdTimestamp :
+			{
+				ISC_TIMESTAMP isc_ts;
+				memcpy(&isc_ts, value.data, sizeof(ISC_TIMESTAMP));
+				IBPP::Timestamp ts;
+				decodeTimestamp(ts, isc_ts);
+				Set(param, ts);
+			}
+			break;
+		default :
+			throw WrongTypeImpl("Row::Set[ValueView]", var->sqltype, ivByte,
+								_("Incompatible types."));
+	}
+	mUpdated[param-1] = true;
+}
+
 /*
 void RowImpl::Set(int param, const IBPP::Value& value)
 {
@@ -427,6 +545,34 @@ bool RowImpl::Get(int column, IBPP::Array& retarray)
 	return pvalue == 0 ? true : false;
 }
 
+bool RowImpl::Get(int column, IBPP::ValueView& retvalue)
+{
+	if (mDescrArea == 0)
+		throw LogicExceptionImpl("Row::Get", _("The row is not initialized."));
+	if (column < 1 || column > mDescrArea->sqld)
+		throw LogicExceptionImpl("Row::Get", _("Variable index out of range."));
+
+	XSQLVAR* var = &(mDescrArea->sqlvar[column-1]);
+	retvalue.type = ColumnType(column);
+	retvalue.scale = var->sqlscale;
+	if ((var->sqltype & 1) && *(var->sqlind) != 0)
+	{
+		retvalue.data = 0;
+		retvalue.length = 0;
+	}
+	else if ((var->sqltype & ~1) == SQL_VARYING)
+	{
+		retvalue.data = var->sqldata + 2;
+		retvalue.length = (int32_t)*(int16_t*)var->sqldata;
+	}
+	else
+	{
+		retvalue.data = var->sqldata;
+		retvalue.length = var->sqllen;
+	}
+	return retvalue.data == 0 ? true : false;
+}
+
 /*
 const IBPP::Value RowImpl::Get(int column)
 {
@@ -592,48 +738,137 @@ int RowImpl::ColumnNum(const std::string& name)
 	if (name.empty())
 		throw LogicExceptionImpl("Row::ColumnNum", _("Column name <empty> not found."));
 
-	XSQLVAR* var;
-	char Uname[sizeof(var->sqlname)+1];		// Max size of sqlname + '\0'
+	// Narrow rows are scanned, which is faster than hashing the name. Wide
+	// rows are indexed by their first lookup, so rows of statements which
+	// are never looked up by name don't pay for it.
+	int varnum;
+	if (mDescrArea->sqld < SCANCOLUMNS)
+		varnum = ScanNames(name.c_str(), (int)name.length());
+	else
+	{
+		if (mNameIndex.empty()) IndexNames();
+		varnum = FindIndexedName(name.c_str(), (int)name.length());
+	}
+	if (varnum == 0)
+		throw LogicExceptionImpl("Row::ColumnNum", _("Could not find matching column."));
+	return varnum;
+}
+
+static inline unsigned NameHash(const char* name, int len)
+{
+	// Case-insensitive FNV-1a
+	unsigned hash = 2166136261U;
+	for (int i = 0; i < len; i++)
+		hash = (hash ^ (unsigned char)toupper(name[i])) * 16777619U;
+	return hash;
+}
 
-	// Local upper case copy of the column name
-	size_t len = name.length();
-	if (len > sizeof(var->sqlname)) len = sizeof(var->sqlname);
-	strncpy(Uname, name.c_str(), len);
-	Uname[len] = '\0';
-	char* p = Uname;
-	while (*p != '\0') { *p = char(toupper(*p)); ++p; }
+static inline bool NameEquals(const char* a, const char* b, int len)
+{
+	for (int i = 0; i < len; i++)
+		if (toupper(a[i]) != toupper(b[i])) return false;
+	return true;
+}
 
-	// Loop through the columns of the descriptor
-	for (int i = 0; i < mDescrArea->sqld; i++)
+const char* RowImpl::IndexedName(int entry, int& len)
+{
+	XSQLVAR* var = &(mDescrArea->sqlvar[(entry > 0 ? entry : -entry) - 1]);
+	if (entry > 0)
 	{
-		var = &(mDescrArea->sqlvar[i]);
-		if (var->sqlname_length != (int16_t)len) continue;
-		if (strncmp(Uname, var->sqlname, len) == 0) return i+1;
+		len = var->sqlname_length;
+		return var->sqlname;
 	}
+	len = var->aliasname_length;
+	return var->aliasname;
+}
 
-	// Failed finding the column name, let's retry using the aliases
-	char Ualias[sizeof(var->aliasname)+1];		// Max size of aliasname + '\0'
+void RowImpl::AddIndexedName(int entry)
+{
+	int len;
+	const char* name = IndexedName(entry, len);
+	if (len == 0) return;
+
+	size_t mask = mNameIndex.size() - 1;
+	for (size_t slot = NameHash(name, len) & mask; ; slot = (slot + 1) & mask)
+	{
+		if (mNameIndex[slot] == 0)
+		{
+			mNameIndex[slot] = entry;
+			return;
+		}
+		// The first column of a name wins, and names win over aliases
+		int otherlen;
+		const char* other = IndexedName(mNameIndex[slot], otherlen);
+		if (otherlen == len && NameEquals(name, other, len)) return;
+	}
+}
 
-	// Local upper case copy of the column name
-	len = name.length();
-	if (len > sizeof(var->aliasname)) len = sizeof(var->aliasname);
-	strncpy(Ualias, name.c_str(), len);
-	Ualias[len] = '\0';
-	p = Ualias;
-	while (*p != '\0') { *p = char(toupper(*p)); ++p; }
+int RowImpl::FindIndexedName(const char* name, int len)
+{
+	if (mNameIndex.empty()) return 0;
+
+	size_t mask = mNameIndex.size() - 1;
+	for (size_t slot = NameHash(name, len) & mask;
+		mNameIndex[slot] != 0; slot = (slot + 1) & mask)
+	{
+		int otherlen;
+		const char* other = IndexedName(mNameIndex[slot], otherlen);
+		if (otherlen == len && NameEquals(name, other, len))
+			return mNameIndex[slot] > 0 ? mNameIndex[slot] : -mNameIndex[slot];
+	}
+	return 0;
+}
+
+// Matches like the index does: names first, then aliases. The names the
+// engine describes are mostly upper case, so an upper case copy of name
+// is compared first, and only if that fails the case is ignored.
+int RowImpl::ScanNames(const char* name, int len)
+{
+	XSQLVAR* var;
+	char uname[sizeof(var->sqlname)];
+	if (len > (int)sizeof(uname)) return 0;
+	for (int i = 0; i < len; i++) uname[i] = char(toupper(name[i]));
 
-	// Loop through the columns of the descriptor
 	for (int i = 0; i < mDescrArea->sqld; i++)
 	{
 		var = &(mDescrArea->sqlvar[i]);
-		if (var->aliasname_length != (int16_t)len) continue;
-		if (strncmp(Ualias, var->aliasname, len) == 0) return i+1;
+		if (var->sqlname_length == len && memcmp(uname, var->sqlname, len) == 0)
+			return i+1;
+	}
+	for (int i = 0; i < mDescrArea->sqld; i++)
+	{
+		var = &(mDescrArea->sqlvar[i]);
+		if (var->aliasname_length == len && memcmp(uname, var->aliasname, len) == 0)
+			return i+1;
 	}
 
-	throw LogicExceptionImpl("Row::ColumnNum", _("Could not find matching column."));
-#ifdef __DMC__
-	return 0;	// DMC errronously warns here about a missing return
-#endif
+	for (int i = 0; i < mDescrArea->sqld; i++)
+	{
+		var = &(mDescrArea->sqlvar[i]);
+		if (var->sqlname_length == len && NameEquals(uname, var->sqlname, len))
+			return i+1;
+	}
+	for (int i = 0; i < mDescrArea->sqld; i++)
+	{
+		var = &(mDescrArea->sqlvar[i]);
+		if (var->aliasname_length == len && NameEquals(uname, var->aliasname, len))
+			return i+1;
+	}
+	return 0;
+}
+
+void RowImpl::IndexNames()
+{
+	mNameIndex.clear();
+	if (mDescrArea == 0 || mDescrArea->sqld == 0) return;
+
+	// Room for all names and aliases, keeping the table at most half full
+	size_t size = 4;
+	while (size < 4 * (size_t)mDescrArea->sqld) size *= 2;
+	mNameIndex.assign(size, 0);
+
+	for (int i = 1; i <= mDescrArea->sqld; i++) AddIndexedName(i);
+	for (int i = 1; i <= mDescrArea->sqld; i++) AddIndexedName(-i);
 }
 
 /*
@@ -1070,6 +1305,7 @@ void* RowImpl::GetValue(int varnum, IITYPE ivType, void* retvalue)
 	void* value;
 	int len;
 	XSQLVAR* var = &(mDescrArea->sqlvar[varnum-1]);
+	void* temp = &mData[varnum-1];	// Storage for a converted value
 
 	// When there is no value (SQL NULL)
 	if ((var->sqltype & 1) && *(var->sqlind) != 0) return 0;
@@ -1101,14 +1337,14 @@ void* RowImpl::GetValue(int varnum, IITYPE ivType, void* retvalue)
 			}
 			else if (ivType == ivBool)
 			{
-				mBools[varnum-1] = 0;
+				*(char*)temp = 0;
 				if (var->sqllen >= 1)
 				{
 					char c = var->sqldata[0];
 					if (c == 't' || c == 'T' || c == 'y' || c == 'Y' ||	c == '1')
-						mBools[varnum-1] = 1;
+						*(char*)temp = 1;
 				}
-				value = &mBools[varnum-1];
+				value = temp;
 			}
 			else throw WrongTypeImpl("RowImpl::GetValue", var->sqltype, ivType,
 										_("Incompatible types."));
@@ -1133,15 +1369,15 @@ void* RowImpl::GetValue(int varnum, IITYPE ivType, void* retvalue)
 			}
 			else if (ivType == ivBool)
 			{
-				mBools[varnum-1] = 0;
+				*(char*)temp = 0;
 				len = *(int16_t*)var->sqldata;
 				if (len >= 1)
 				{
 					char c = var->sqldata[2];
 					if (c == 't' || c == 'T' || c == 'y' || c == 'Y' ||	c == '1')
-						mBools[varnum-1] = 1;
+						*(char*)temp = 1;
 				}
-				value = &mBools[varnum-1];
+				value = temp;
 			}
 			else throw WrongTypeImpl("RowImpl::GetValue", var->sqltype, ivType,
 										_("Incompatible types."));
@@ -1154,34 +1390,34 @@ void* RowImpl::GetValue(int varnum, IITYPE ivType, void* retvalue)
 			}
 			else if (ivType == ivBool)
 			{
-				if (*(int16_t*)var->sqldata == 0) mBools[varnum-1] = 0;
-				else mBools[varnum-1] = 1;
-				value = &mBools[varnum-1];
+				if (*(int16_t*)var->sqldata == 0) *(char*)temp = 0;
+				else *(char*)temp = 1;
+				value = temp;
 			}
 			else if (ivType == ivInt32)
 			{
-				mInt32s[varnum-1] = *(int16_t*)var->sqldata;
-				value = &mInt32s[varnum-1];
+				*(int32_t*)temp = *(int16_t*)var->sqldata;
+				value = temp;
 			}
 			else if (ivType == ivInt64)
 			{
-				mInt64s[varnum-1] = *(int16_t*)var->sqldata;
-				value = &mInt64s[varnum-1];
+				*(int64_t*)temp = *(int16_t*)var->sqldata;
+				value = temp;
 			}
 			else if (ivType == ivFloat)
 			{
 				// This SQL_SHORT is a NUMERIC(x,y), scale it !
 				double divisor = consts::dscales[-var->sqlscale];
-				mFloats[varnum-1] = (float)(*(int16_t*)var->sqldata / divisor);
+				*(float*)temp = (float)(*(int16_t*)var->sqldata / divisor);
 
-				value = &mFloats[varnum-1];
+				value = temp;
 			}
 			else if (ivType == ivDouble)
 			{
 				// This SQL_SHORT is a NUMERIC(x,y), scale it !
 				double divisor = consts::dscales[-var->sqlscale];
-				mNumerics[varnum-1] = *(int16_t*)var->sqldata / divisor;
-				value = &mNumerics[varnum-1];
+				*(double*)temp = *(int16_t*)var->sqldata / divisor;
+				value = temp;
 			}
 			else throw WrongTypeImpl("RowImpl::GetValue", var->sqltype, ivType,
 										_("Incompatible types."));
@@ -1194,9 +1430,9 @@ void* RowImpl::GetValue(int varnum, IITYPE ivType, void* retvalue)
 			}
 			else if (ivType == ivBool)
 			{
-				if (*(int32_t*)var->sqldata == 0) mBools[varnum-1] = 0;
-				else mBools[varnum-1] = 1;
-				value = &mBools[varnum-1];
+				if (*(int32_t*)var->sqldata == 0) *(char*)temp = 0;
+				else *(char*)temp = 1;
+				value = temp;
 			}
 			else if (ivType == ivInt16)
 			{
@@ -1204,27 +1440,27 @@ void* RowImpl::GetValue(int varnum, IITYPE ivType, void* retvalue)
 				if (tmp < consts::min16 || tmp > consts::max16)
 					throw LogicExceptionImpl("RowImpl::GetValue",
 						_("Out of range numeric conversion !"));
-				mInt16s[varnum-1] = (int16_t)tmp;
-				value = &mInt16s[varnum-1];
+				*(int16_t*)temp = (int16_t)tmp;
+				value = temp;
 			}
 			else if (ivType == ivInt64)
 			{
-				mInt64s[varnum-1] = *(int32_t*)var->sqldata;
-				value = &mInt64s[varnum-1];
+				*(int64_t*)temp = *(int32_t*)var->sqldata;
+				value = temp;
 			}
 			else if (ivType == ivFloat)
 			{
 				// This SQL_LONG is a NUMERIC(x,y), scale it !
 				double divisor = consts::dscales[-var->sqlscale];
-				mFloats[varnum-1] = (float)(*(int32_t*)var->sqldata / divisor);
-				value = &mFloats[varnum-1];
+				*(float*)temp = (float)(*(int32_t*)var->sqldata / divisor);
+				value = temp;
 			}
 			else if (ivType == ivDouble)
 			{
 				// This SQL_LONG is a NUMERIC(x,y), scale it !
 				double divisor = consts::dscales[-var->sqlscale];
-				mNumerics[varnum-1] = *(int32_t*)var->sqldata / divisor;
-				value = &mNumerics[varnum-1];
+				*(double*)temp = *(int32_t*)var->sqldata / divisor;
+				value = temp;
 			}
 			else throw WrongTypeImpl("RowImpl::GetValue", var->sqltype, ivType,
 										_("Incompatible types."));
@@ -1237,9 +1473,9 @@ void* RowImpl::GetValue(int varnum, IITYPE ivType, void* retvalue)
 			}
 			else if (ivType == ivBool)
 			{
-				if (*(int64_t*)var->sqldata == 0) mBools[varnum-1] = 0;
-				else mBools[varnum-1] = 1;
-				value = &mBools[varnum-1];
+				if (*(int64_t*)var->sqldata == 0) *(char*)temp = 0;
+				else *(char*)temp = 1;
+				value = temp;
 			}
 			else if (ivType == ivInt16)
 			{
@@ -1247,8 +1483,8 @@ void* RowImpl::GetValue(int varnum, IITYPE ivType, void* retvalue)
 				if (tmp < consts::min16 || tmp > consts::max16)
 					throw LogicExceptionImpl("RowImpl::GetValue",
 						_("Out of range numeric conversion !"));
-				mInt16s[varnum-1] = (int16_t)tmp;
-				value = &mInt16s[varnum-1];
+				*(int16_t*)temp = (int16_t)tmp;
+				value = temp;
 			}
 			else if (ivType == ivInt32)
 			{
@@ -1256,22 +1492,22 @@ void* RowImpl::GetValue(int varnum, IITYPE ivType, void* retvalue)
 				if (tmp < consts::min32 || tmp > consts::max32)
 					throw LogicExceptionImpl("RowImpl::GetValue",
 						_("Out of range numeric conversion !"));
-				mInt32s[varnum-1] = (int32_t)tmp;
-				value = &mInt32s[varnum-1];
+				*(int32_t*)temp = (int32_t)tmp;
+				value = temp;
 			}
 			else if (ivType == ivFloat)
 			{
 				// This SQL_INT64 is a NUMERIC(x,y), scale it !
 				double divisor = consts::dscales[-var->sqlscale];
-				mFloats[varnum-1] = (float)(*(int64_t*)var->sqldata / divisor);
-				value = &mFloats[varnum-1];
+				*(float*)temp = (float)(*(int64_t*)var->sqldata / divisor);
+				value = temp;
 			}
 			else if (ivType == ivDouble)
 			{
 				// This SQL_INT64 is a NUMERIC(x,y), scale it !
 				double divisor = consts::dscales[-var->sqlscale];
-				mNumerics[varnum-1] = *(int64_t*)var->sqldata / divisor;
-				value = &mNumerics[varnum-1];
+				*(double*)temp = *(int64_t*)var->sqldata / divisor;
+				value = temp;
 			}
 			else throw WrongTypeImpl("RowImpl::GetValue", var->sqltype, ivType,
 										_("Incompatible types."));
@@ -1292,9 +1528,9 @@ void* RowImpl::GetValue(int varnum, IITYPE ivType, void* retvalue)
 			{
 				// Round to scale y of NUMERIC(x,y)
 				double multiplier = consts::dscales[-var->sqlscale];
-				mNumerics[varnum-1] =
+				*(double*)temp =
 					floor(*(double*)var->sqldata * multiplier + 0.5) / multiplier;
-				value = &mNumerics[varnum-1];
+				value = temp;
 			}
 			else value = var->sqldata;
 			break;
@@ -1364,43 +1600,13 @@ void RowImpl::Free()
 {
 	if (mDescrArea != 0)
 	{
-		for (int i = 0; i < mDescrArea->sqln; i++)
-		{
-			XSQLVAR* var = &(mDescrArea->sqlvar[i]);
-			if (var->sqldata != 0)
-			{
-				switch (var->sqltype & ~1)
-				{
-					case SQL_ARRAY :
-					case SQL_BLOB :		delete (ISC_QUAD*) var->sqldata; break;
-					case SQL_TIMESTAMP :delete (ISC_TIMESTAMP*) var->sqldata; break;
-					case SQL_TYPE_TIME :delete (ISC_TIME*) var->sqldata; break;
-					case SQL_TYPE_DATE :delete (ISC_DATE*) var->sqldata; break;
-					case SQL_TEXT :
-					case SQL_VARYING :	delete [] var->sqldata; break;
-					case SQL_SHORT :	delete (int16_t*) var->sqldata; break;
-					case SQL_LONG :		delete (int32_t*) var->sqldata; break;
-					case SQL_INT64 :	delete (int64_t*) var->sqldata; break;
-					case SQL_FLOAT : 	delete (float*) var->sqldata; break;
-					case SQL_DOUBLE :	delete (double*) var->sqldata; break;
-					default : throw LogicExceptionImpl("RowImpl::Free",
-								_("Found an unknown sqltype !"));
-				}
-			}
-			if (var->sqlind != 0) delete var->sqlind;
-		}
 		delete [] (char*)mDescrArea;
 		mDescrArea = 0;
 	}
 
-	mNumerics.clear();
-	mFloats.clear();
-	mInt64s.clear();
-	mInt32s.clear();
-	mInt16s.clear();
-	mBools.clear();
-	mStrings.clear();
+	mData.clear();
 	mUpdated.clear();
+	mNameIndex.clear();
 
 	mDialect = 0;
 	mDatabase = 0;
@@ -1415,69 +1621,75 @@ void RowImpl::Resize(int n)
     mDescrArea = (XSQLDA*) new char[size];
 
 	memset(mDescrArea, 0, size);
-	mNumerics.resize(n);
-	mFloats.resize(n);
-	mInt64s.resize(n);
-	mInt32s.resize(n);
-	mInt16s.resize(n);
-	mBools.resize(n);
-	mStrings.resize(n);
-	mUpdated.resize(n);
-	for (int i = 0; i < n; i++)
-	{
-		mNumerics[i] = 0.0;
-		mFloats[i] = 0.0;
-		mInt64s[i] = 0;
-		mInt32s[i] = 0;
-		mInt16s[i] = 0;
-		mBools[i] = 0;
-		mStrings[i].erase();
-		mUpdated[i] = false;
-	}
+	mUpdated.assign(n, false);
 
 	mDescrArea->version = SQLDA_VERSION1;
 	mDescrArea->sqln = (int16_t)n;
 }
 
+// Returns the bytes needed for the data of var and their alignment
+static int VariableSize(const XSQLVAR* var, int& alignment)
+{
+	int size;
+	switch (var->sqltype & ~1)
+	{
+		case SQL_ARRAY :
+		case SQL_BLOB :		size = sizeof(ISC_QUAD); break;
+		case SQL_TIMESTAMP :size = sizeof(ISC_TIMESTAMP); break;
+		case SQL_TYPE_TIME :size = sizeof(ISC_TIME); break;
+		case SQL_TYPE_DATE :size = sizeof(ISC_DATE); break;
+		case SQL_TEXT :		alignment = 1; return var->sqllen+1;
+		case SQL_VARYING :	alignment = 2; return var->sqllen+3;
+		case SQL_SHORT :	size = sizeof(int16_t); break;
+		case SQL_LONG :		size = sizeof(int32_t); break;
+		case SQL_INT64 :	size = sizeof(int64_t); break;
+		case SQL_FLOAT : 	size = sizeof(float); break;
+		case SQL_DOUBLE :	size = sizeof(double); break;
+		default : throw LogicExceptionImpl("RowImpl::AllocVariables",
+					_("Found an unknown sqltype !"));
+	}
+	alignment = size < 8 ? size : 8;
+	return size;
+}
+
 void RowImpl::AllocVariables()
 {
-	int i;
-	for (i = 0; i < mDescrArea->sqld; i++)
+	// All columns share one block: an 8 byte temporary per column for the
+	// converted values GetValue() returns, then the null indicators, then
+	// the data of each column at its natural alignment.
+	int n = mDescrArea->sqld;
+	int alignment;
+	size_t size = n * sizeof(double) + n * sizeof(short);
+	for (int i = 0; i < n; i++)
+	{
+		int varsize = VariableSize(&(mDescrArea->sqlvar[i]), alignment);
+		size = (size + alignment - 1) / alignment * alignment + varsize;
+	}
+	mData.assign((size + sizeof(double) - 1) / sizeof(double), 0.0);
+
+	char* data = (char*)&mData[0];
+	short* indicators = (short*)(data + n * sizeof(double));
+	size = n * sizeof(double) + n * sizeof(short);
+	for (int i = 0; i < n; i++)
 	{
 		XSQLVAR* var = &(mDescrArea->sqlvar[i]);
+		int varsize = VariableSize(var, alignment);
+		size = (size + alignment - 1) / alignment * alignment;
+		var->sqldata = data + size;
+		size += varsize;
 		switch (var->sqltype & ~1)
 		{
-			case SQL_ARRAY :
-			case SQL_BLOB :		var->sqldata = (char*) new ISC_QUAD;
-								memset(var->sqldata, 0, sizeof(ISC_QUAD));
+			case SQL_TEXT :		memset(var->sqldata, ' ', var->sqllen);
 								break;
-			case SQL_TIMESTAMP :var->sqldata = (char*) new ISC_TIMESTAMP;
-								memset(var->sqldata, 0, sizeof(ISC_TIMESTAMP));
+			case SQL_VARYING :	memset(var->sqldata+2, ' ', var->sqllen);
 								break;
-			case SQL_TYPE_TIME :var->sqldata = (char*) new ISC_TIME;
-								memset(var->sqldata, 0, sizeof(ISC_TIME));
-								break;
-			case SQL_TYPE_DATE :var->sqldata = (char*) new ISC_DATE;
-								memset(var->sqldata, 0, sizeof(ISC_DATE));
-								break;
-			case SQL_TEXT :		var->sqldata = new char[var->sqllen+1];
-								memset(var->sqldata, ' ', var->sqllen);
-								var->sqldata[var->sqllen] = '\0';
-								break;
-			case SQL_VARYING :	var->sqldata = new char[var->sqllen+3];
-								memset(var->sqldata, 0, 2);
-								memset(var->sqldata+2, ' ', var->sqllen);
-								var->sqldata[var->sqllen+2] = '\0';
-								break;
-			case SQL_SHORT :	var->sqldata = (char*) new int16_t(0); break;
-			case SQL_LONG :		var->sqldata = (char*) new int32_t(0); break;
-			case SQL_INT64 :	var->sqldata = (char*) new int64_t(0); break;
-			case SQL_FLOAT : 	var->sqldata = (char*) new float(0.0); break;
-			case SQL_DOUBLE :	var->sqldata = (char*) new double(0.0); break;
-			default : throw LogicExceptionImpl("RowImpl::AllocVariables",
-						_("Found an unknown sqltype !"));
 		}
-		if (var->sqltype & 1) var->sqlind = new short(-1);	// 0 indicator
+		if (var->sqltype & 1)
+		{
+			var->sqlind = &indicators[i];
+			*var->sqlind = -1;	// 0 indicator
+		}
+		else var->sqlind = 0;
 	}
 }
 
@@ -1499,51 +1711,23 @@ RowImpl& RowImpl::operator=(const RowImpl& copied)
     mDescrArea = (XSQLDA*) new char[size];
 	memcpy(mDescrArea, copied.mDescrArea, size);
 
-	// Copy of the columns data
-	for (int i = 0; i < mDescrArea->sqld; i++)
+	// Copy of the columns data, which is one block, so only the pointers
+	// into it must be moved to the copy
+	mData = copied.mData;
+	if (! mData.empty())
 	{
-		XSQLVAR* var = &(mDescrArea->sqlvar[i]);
-		XSQLVAR* org = &(copied.mDescrArea->sqlvar[i]);
-		switch (var->sqltype & ~1)
+		char* data = (char*)&mData[0];
+		const char* org = (const char*)&copied.mData[0];
+		for (int i = 0; i < mDescrArea->sqld; i++)
 		{
-			case SQL_ARRAY :
-			case SQL_BLOB :		var->sqldata = (char*) new ISC_QUAD;
-								memcpy(var->sqldata, org->sqldata, sizeof(ISC_QUAD));
-								break;
-			case SQL_TIMESTAMP :var->sqldata = (char*) new ISC_TIMESTAMP;
-								memcpy(var->sqldata, org->sqldata, sizeof(ISC_TIMESTAMP));
-								break;
-			case SQL_TYPE_TIME :var->sqldata = (char*) new ISC_TIME;
-								memcpy(var->sqldata, org->sqldata, sizeof(ISC_TIME));
-								break;
-			case SQL_TYPE_DATE :var->sqldata = (char*) new ISC_DATE;
-								memcpy(var->sqldata, org->sqldata, sizeof(ISC_DATE));
-								break;
-			case SQL_TEXT :		var->sqldata = new char[var->sqllen+1];
-								memcpy(var->sqldata, org->sqldata, var->sqllen+1);
-								break;
-			case SQL_VARYING :	var->sqldata = new char[var->sqllen+3];
-								memcpy(var->sqldata, org->sqldata, var->sqllen+3);
-								break;
-			case SQL_SHORT :	var->sqldata = (char*) new int16_t(*(int16_t*)org->sqldata); break;
-			case SQL_LONG :		var->sqldata = (char*) new int32_t(*(int32_t*)org->sqldata); break;
-			case SQL_INT64 :	var->sqldata = (char*) new int64_t(*(int64_t*)org->sqldata); break;
-			case SQL_FLOAT : 	var->sqldata = (char*) new float(*(float*)org->sqldata); break;
-			case SQL_DOUBLE :	var->sqldata = (char*) new double(*(double*)org->sqldata); break;
-			default : throw LogicExceptionImpl("RowImpl::Ctor",
-						_("Found an unknown sqltype !"));
+			XSQLVAR* var = &(mDescrArea->sqlvar[i]);
+			if (var->sqldata != 0) var->sqldata = data + (var->sqldata - org);
+			if (var->sqlind != 0) var->sqlind = (short*)(data + ((char*)var->sqlind - org));
 		}
-		if (var->sqltype & 1) var->sqlind = new short(*org->sqlind);	// 0 indicator
 	}
 
-	// Pointers init, real data copy
-	mNumerics = copied.mNumerics;
-	mFloats = copied.mFloats;
-	mInt64s = copied.mInt64s;
-	mInt32s = copied.mInt32s;
-	mInt16s = copied.mInt16s;
-	mBools = copied.mBools;
-	mStrings = copied.mStrings;
+	mUpdated = copied.mUpdated;
+	mNameIndex = copied.mNameIndex;
 
 	mDialect = copied.mDialect;
 	mDatabase = copied.mDatabase;
@@ -67,25 +67,14 @@ void StatementImpl::Prepare(const std::string& sql)
 		throw SQLExceptionImpl(status, "Statement::Prepare",
 			_("isc_dsql_allocate_statement failed"));
 
-	// Empirical estimate of parameters count and output columns count.
-	// This is by far not an exact estimation, which would require parsing the
-	// SQL statement. If the SQL statement contains '?' and ',' in string
-	// constants, this count will obviously be wrong, but it will be exagerated.
-	// It won't hurt. We just try to not have to re-allocate those descriptors later.
-	// So we prefer to get them a little bit larger than needed than the other way.
-	int16_t inEstimate = 0;
-	int16_t outEstimate = 1;
-	for (size_t i = 0; i < strlen(sql.c_str()); i++)
-	{
-		if (sql[i] == '?') ++inEstimate;
+	// Estimates the output columns by the commas in the SQL, so that the
+	// prepare describes them in the same round trip. Commas in string
+	// constants make the estimate too large, which doesn't hurt. A too
+	// small output descriptor is resized and described again below.
+	int outEstimate = 1;
+	const size_t sqlLength = sql.length();
+	for (size_t i = 0; i < sqlLength && outEstimate < std::numeric_limits<short>::max(); i++)
 		if (sql[i] == ',') ++outEstimate;
-	}
-
-	/*
-	DebugStream()<< "Prepare(\""<< sql<< "\")"<< fds;
-	DebugStream()<< _("Estimation: ")<< inEstimate<< _(" IN parameters and ")
-			<< outEstimate<< _(" OUT columns")<< fds;
-	*/
 
 	// Allocates output descriptor and prepares the statement
 	mOutRow = new RowImpl(mDatabase->Dialect(), outEstimate, mDatabase, mTransaction);
@@ -104,33 +93,54 @@ void StatementImpl::Prepare(const std::string& sql)
 			_("isc_dsql_prepare failed"));
 	}
 
-	// Read what kind of statement was prepared
+	// Read what kind of statement was prepared and the exact number of its
+	// parameters
 	status.Reset();
-	char itemsReq[] = {isc_info_sql_stmt_type};
-	char itemsRes[8];
-	(*gds.Call()->m_dsql_sql_info)(status.Self(), &mHandle, 1, itemsReq,
-		sizeof(itemsRes), itemsRes);
+	char itemsReq[] = {isc_info_sql_stmt_type,
+		isc_info_sql_bind, isc_info_sql_num_variables};
+	char itemsRes[64];
+	(*gds.Call()->m_dsql_sql_info)(status.Self(), &mHandle, sizeof(itemsReq),
+		itemsReq, sizeof(itemsRes), itemsRes);
 	if (status.Errors())
 	{
 		Close();
 		throw SQLExceptionImpl(status, "Statement::Prepare",
 			_("isc_dsql_sql_info failed"));
 	}
-	if (itemsRes[0] == isc_info_sql_stmt_type)
+
+	int stmtType = 0;
+	int inCount = 0;
+	int* count = 0;
+	char* p = itemsRes;
+	char* end = itemsRes + sizeof(itemsRes);
+	while (p < end && *p != isc_info_end)
+	{
+		// isc_info_sql_bind only tells which descriptor the following
+		// isc_info_sql_num_variables belongs to
+		char item = *p++;
+		if (item == isc_info_sql_bind) { count = &inCount; continue; }
+		if (item == isc_info_truncated || p + 2 > end) break;
+		short len = (short)(*gds.Call()->m_vax_integer)(p, 2);
+		p += 2;
+		if (p + len > end) break;
+		int value = (*gds.Call()->m_vax_integer)(p, len);
+		p += len;
+		if (item == isc_info_sql_stmt_type) stmtType = value;
+		else if (item == isc_info_sql_num_variables && count != 0) *count = value;
+	}
+
+	switch (stmtType)
 	{
-		switch (itemsRes[3])
-		{
-			case isc_info_sql_stmt_select :		mType = IBPP::stSelect; break;
-			case isc_info_sql_stmt_insert :		mType = IBPP::stInsert; break;
-			case isc_info_sql_stmt_update :		mType = IBPP::stUpdate; break;
-			case isc_info_sql_stmt_delete :		mType = IBPP::stDelete; break;
-			case isc_info_sql_stmt_ddl :		mType = IBPP::stDDL; break;
-			case isc_info_sql_stmt_exec_procedure : mType = IBPP::stExecProcedure; break;
-			case isc_info_sql_stmt_select_for_upd : mType = IBPP::stSelectUpdate; break;
-			case isc_info_sql_stmt_set_generator :	mType = IBPP::stSetGenerator; break;
-			case isc_info_sql_stmt_savepoint :	mType = IBPP::stSavePoint; break;
-			default : mType = IBPP::stUnsupported;
-		}
+		case isc_info_sql_stmt_select :		mType = IBPP::stSelect; break;
+		case isc_info_sql_stmt_insert :		mType = IBPP::stInsert; break;
+		case isc_info_sql_stmt_update :		mType = IBPP::stUpdate; break;
+		case isc_info_sql_stmt_delete :		mType = IBPP::stDelete; break;
+		case isc_info_sql_stmt_ddl :		mType = IBPP::stDDL; break;
+		case isc_info_sql_stmt_exec_procedure : mType = IBPP::stExecProcedure; break;
+		case isc_info_sql_stmt_select_for_upd : mType = IBPP::stSelectUpdate; break;
+		case isc_info_sql_stmt_set_generator :	mType = IBPP::stSetGenerator; break;
+		case isc_info_sql_stmt_savepoint :	mType = IBPP::stSavePoint; break;
+		default : mType = IBPP::stUnsupported;
 	}
 	if (mType == IBPP::stUnknown || mType == IBPP::stUnsupported)
 	{
@@ -144,21 +154,12 @@ void StatementImpl::Prepare(const std::string& sql)
 		// Get rid of the output descriptor, if it wasn't required (no output)
 		mOutRow->Release();
 		mOutRow = 0;
-		/*
-		DebugStream()<< _("Dropped output descriptor which was not required")<< fds;
-		*/
 	}
 	else if (mOutRow->Columns() > mOutRow->AllocatedSize())
 	{
 		// Resize the output descriptor (which is too small).
 		// The statement does not need to be prepared again, though the
 		// output columns must be described again.
-
-		/*
-		DebugStream()<< _("Resize output descriptor from ")
-			<< mOutRow->AllocatedSize()<< _(" to ")<< mOutRow->Columns()<< fds;
-		*/
-
 		mOutRow->Resize(mOutRow->Columns());
 		status.Reset();
 		(*gds.Call()->m_dsql_describe)(status.Self(), &mHandle, 1, mOutRow->Self());
@@ -170,10 +171,10 @@ void StatementImpl::Prepare(const std::string& sql)
 		}
 	}
 
-	if (inEstimate > 0)
+	if (inCount > 0)
 	{
-		// Ready an input descriptor
-		mInRow = new RowImpl(mDatabase->Dialect(), inEstimate, mDatabase, mTransaction);
+		// Allocates and fills the input descriptor
+		mInRow = new RowImpl(mDatabase->Dialect(), inCount, mDatabase, mTransaction);
 		mInRow->AddRef();
 
 		status.Reset();
@@ -184,38 +185,6 @@ void StatementImpl::Prepare(const std::string& sql)
 			throw SQLExceptionImpl(status, "Statement::Prepare",
 				_("isc_dsql_describe_bind failed"));
 		}
-
-		if (mInRow->Columns() == 0)
-		{
-			// Get rid of the input descriptor, if it wasn't required (no parameters)
-			mInRow->Release();
-			mInRow = 0;
-			/*
-			DebugStream()<< _("Dropped input descriptor which was not required")<< fds;
-			*/
-		}
-		else if (mInRow->Columns() > mInRow->AllocatedSize())
-		{
-			// Resize the input descriptor (which is too small).
-			// The statement does not need to be prepared again, though the
-			// parameters must be described again.
-
-			/*
-			DebugStream()<< _("Resize input descriptor from ")
-					<< mInRow->AllocatedSize()<< _(" to ")
-					<< mInRow->Columns()<< fds;
-			*/
-
-			mInRow->Resize(mInRow->Columns());
-			status.Reset();
-			(*gds.Call()->m_dsql_describe_bind)(status.Self(), &mHandle, 1, mInRow->Self());
-			if (status.Errors())
-			{
-				Close();
-				throw SQLExceptionImpl(status, "Statement::Prepare",
-					_("isc_dsql_describe_bind failed"));
-			}
-		}
 	}
 
 	// Allocates variables of the input descriptor
@@ -480,6 +449,7 @@ void StatementImpl::Close()
 
 	if (mInRow != 0) { mInRow->Release(); mInRow = 0; }
 	if (mOutRow != 0) { mOutRow->Release(); mOutRow = 0; }
+	mColumnArrays.clear();
 
 	mResultSetAvailable = false;
 	mCursorOpened = false;
@@ -656,6 +626,16 @@ void StatementImpl::Set(int param, const IBPP::DBKey& key)
 	mInRow->Set(param, key);
 }
 
+void StatementImpl::Set(int param, const IBPP::ValueView& value)
+{
+	if (mHandle == 0)
+		throw LogicExceptionImpl("Statement::Set[ValueView]", _("No statement has been prepared."));
+	if (mInRow == 0)
+		throw LogicExceptionImpl("Statement::Set[ValueView]", _("The statement does not take parameters."));
+
+	mInRow->Set(param, value);
+}
+
 /*
 void StatementImpl::Set(int param, const IBPP::Value& value)
 {
@@ -856,6 +836,14 @@ bool StatementImpl::Get(int column, IBPP::Array& array)
 	return mOutRow->Get(column, array);
 }
 
+bool StatementImpl::Get(int column, IBPP::ValueView& value)
+{
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::Get", _("The row is not initialized."));
+
+	return mOutRow->Get(column, value);
+}
+
 /*
 const IBPP::Value StatementImpl::Get(int column)
 {
@@ -1072,6 +1060,28 @@ int StatementImpl::Columns()
 	return mOutRow->Columns();
 }
 
+IBPP::Array StatementImpl::ColumnArray(int varnum)
+{
+	if (mHandle == 0)
+		throw LogicExceptionImpl("Statement::ColumnArray", _("No statement has been prepared."));
+	if (mOutRow == 0)
+		throw LogicExceptionImpl("Statement::ColumnArray", _("The statement does not return results."));
+	if (mOutRow->ColumnType(varnum) != IBPP::sdArray)
+		throw LogicExceptionImpl("Statement::ColumnArray", _("Not an array column."));
+
+	// isc_array_lookup_bounds() is a server round trip, each column is
+	// described once and the Array is reused for every fetched row.
+	if ((int)mColumnArrays.size() < varnum) mColumnArrays.resize(varnum);
+	IBPP::Array& array = mColumnArrays[varnum-1];
+	if (array.intf() == 0)
+	{
+		IBPP::Array described = new ArrayImpl(mDatabase, mTransaction);
+		described->Describe(mOutRow->ColumnTable(varnum), mOutRow->ColumnName(varnum));
+		array = described;
+	}
+	return array;
+}
+
 int StatementImpl::ColumnNum(const std::string& name)
 {
 	if (mOutRow == 0)
@@ -1252,6 +1262,7 @@ void StatementImpl::AttachTransactionImpl(TransactionImpl* transaction)
 	if (mTransaction != 0) mTransaction->DetachStatementImpl(this);
 	mTransaction = transaction;
 	mTransaction->AttachStatementImpl(this);
+	mColumnArrays.clear();	// They are bound to the previous transaction
 }
 
 void StatementImpl::DetachTransactionImpl()
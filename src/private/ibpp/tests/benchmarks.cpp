@@ -0,0 +1,247 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//	File    : $Id$
+//	Subject : IBPP, BENCHMARKS program
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//	(C) Copyright 2000-2006 T.I.P. Group S.A. and the IBPP Team (www.ibpp.org)
+//
+//	The contents of this file are subject to the IBPP License (the "License");
+//	you may not use this file except in compliance with the License.  You may
+//	obtain a copy of the License at http://www.ibpp.org or in the 'license.txt'
+//	file which must have been distributed along with this file.
+//
+//	This software, distributed under the License, is distributed on an "AS IS"
+//	basis, WITHOUT WARRANTY OF ANY KIND, either express or implied.  See the
+//	License for the specific language governing rights and limitations
+//	under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//	COMMENTS
+//	* Tabulations should be set every four characters when editing this file.
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//	This file is NOT part of the IBPP core files, like tests.cpp it is a
+//	program used during development of IBPP itself. It measures some hot
+//	paths of the core and is built and linked the same way as tests.cpp:
+//
+//		benchmarks columnnum	Row::ColumnNum() on narrow and wide rows,
+//								no server needed
+//		benchmarks prepare <database> [<server> <user> <password>]
+//								Statement::Prepare() against the length of the
+//								SQL, skipped if the database can't be reached
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef _MSC_VER
+#pragma warning(disable: 4786 4996)
+#endif
+
+#include "../core/_ibpp.h"
+
+#ifdef HAS_HDRSTOP
+#pragma hdrstop
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+
+#ifdef IBPP_WINDOWS
+#include <windows.h>
+#else
+#include <sys/time.h>
+#endif
+
+using namespace ibpp_internals;
+
+namespace
+{
+	// Seconds of processor time since the start of the program
+	double Seconds()
+	{
+		return double(clock()) / CLOCKS_PER_SEC;
+	}
+
+	// Seconds of real time, which includes waiting for the server
+	double WallSeconds()
+	{
+#ifdef IBPP_WINDOWS
+		return GetTickCount() / 1000.0;
+#else
+		struct timeval tv;
+		gettimeofday(&tv, 0);
+		return tv.tv_sec + tv.tv_usec / 1e6;
+#endif
+	}
+
+	// A row described like the result of a statement with the given
+	// number of columns, named COLUMN_n and aliased ALIAS_n
+	void DescribeRow(RowImpl& row, int columns)
+	{
+		XSQLDA* da = row.Self();
+		da->sqld = (short)columns;
+		for (int i = 0; i < columns; i++)
+		{
+			XSQLVAR* var = &(da->sqlvar[i]);
+			var->sqltype = SQL_LONG + 1;
+			var->sqllen = sizeof(int32_t);
+			var->sqlname_length = (short)sprintf(var->sqlname, "COLUMN_%d", i + 1);
+			var->aliasname_length = (short)sprintf(var->aliasname, "ALIAS_%d", i + 1);
+		}
+	}
+
+	// The lookup before the names were indexed: an upper case copy of the
+	// name, then a scan of the names and one of the aliases
+	int ScanColumnNum(XSQLDA* da, const std::string& name)
+	{
+		char uname[sizeof(da->sqlvar[0].sqlname)+1];
+		size_t len = name.length();
+		if (len > sizeof(da->sqlvar[0].sqlname)) len = sizeof(da->sqlvar[0].sqlname);
+		strncpy(uname, name.c_str(), len);
+		uname[len] = '\0';
+		for (char* p = uname; *p != '\0'; ++p) *p = char(toupper(*p));
+
+		for (int i = 0; i < da->sqld; i++)
+		{
+			XSQLVAR* var = &(da->sqlvar[i]);
+			if (var->sqlname_length == (int16_t)len && strncmp(uname, var->sqlname, len) == 0)
+				return i+1;
+		}
+		for (int i = 0; i < da->sqld; i++)
+		{
+			XSQLVAR* var = &(da->sqlvar[i]);
+			if (var->aliasname_length == (int16_t)len && strncmp(uname, var->aliasname, len) == 0)
+				return i+1;
+		}
+		return 0;
+	}
+
+	// Looks up each column by it's lower case name and alias, as the
+	// name-based Get() overloads do for each cell of a row. ColumnNum()
+	// scans rows narrower than 32 columns and indexes the wider ones.
+	int ColumnNumBenchmark()
+	{
+		const int widths[] = { 20, 31, 32, 200, 500 };
+		const int lookups = 2000000;
+
+		printf("columnnum: columns, old scan ns/lookup, ColumnNum ns/lookup\n");
+		for (unsigned w = 0; w < sizeof(widths) / sizeof(widths[0]); w++)
+		{
+			int columns = widths[w];
+			RowImpl row(3, columns, 0, 0);
+			DescribeRow(row, columns);
+
+			std::vector<std::string> names;
+			for (int i = 1; i <= columns; i++)
+			{
+				char name[32];
+				sprintf(name, "column_%d", i);
+				names.push_back(name);
+				sprintf(name, "alias_%d", i);
+				names.push_back(name);
+			}
+
+			long check = 0;
+			double start = Seconds();
+			for (int i = 0; i < lookups; i++)
+				check += ScanColumnNum(row.Self(), names[i % names.size()]);
+			double scan = Seconds() - start;
+
+			// The index of a wide row is built by it's first lookup
+
+			start = Seconds();
+			for (int i = 0; i < lookups; i++)
+				check -= row.ColumnNum(names[i % names.size()]);
+			double current = Seconds() - start;
+
+			if (check != 0)
+			{
+				printf("columnnum: the lookups disagree\n");
+				return 1;
+			}
+			printf("columnnum: %d, %.1f, %.1f\n", columns,
+				scan * 1e9 / lookups, current * 1e9 / lookups);
+		}
+		return 0;
+	}
+
+	// A generated statement with the given number of columns, each a
+	// parameter and a string literal with commas
+	std::string GeneratedSql(int columns)
+	{
+		std::string sql = "SELECT ";
+		char column[80];
+		for (int i = 1; i <= columns; i++)
+		{
+			sprintf(column, "%sCAST(? AS INTEGER) AS C%d, 'a, b, c' AS S%d",
+				i > 1 ? ", " : "", i, i);
+			sql.append(column);
+		}
+		return sql.append(" FROM RDB$DATABASE");
+	}
+
+	int PrepareBenchmark(const std::string& server, const std::string& database,
+		const std::string& user, const std::string& password)
+	{
+		IBPP::Database db;
+		try
+		{
+			db = IBPP::DatabaseFactory(server, database, user, password);
+			db->Connect();
+		}
+		catch (IBPP::Exception& e)
+		{
+			printf("prepare: skipped, can't connect\n%s\n", e.what());
+			return 0;
+		}
+
+		const int columns[] = { 10, 100, 400, 800 };
+		const int prepares = 50;
+
+		IBPP::Transaction tr = IBPP::TransactionFactory(db, IBPP::amRead);
+		tr->Start();
+		IBPP::Statement st = IBPP::StatementFactory(db, tr);
+		printf("prepare: sql bytes, columns, parameters, us/prepare\n");
+		for (unsigned c = 0; c < sizeof(columns) / sizeof(columns[0]); c++)
+		{
+			std::string sql = GeneratedSql(columns[c]);
+			st->Prepare(sql);	// warms up the server's metadata cache
+			double start = WallSeconds();
+			for (int i = 0; i < prepares; i++)
+				st->Prepare(sql);
+			double elapsed = WallSeconds() - start;
+			printf("prepare: %d, %d, %d, %.0f\n", (int)sql.length(),
+				st->Columns(), st->Parameters(), elapsed * 1e6 / prepares);
+		}
+		tr->Commit();
+		db->Disconnect();
+		return 0;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc == 2 && strcmp(argv[1], "columnnum") == 0)
+		return ColumnNumBenchmark();
+	if (argc >= 2 && strcmp(argv[1], "prepare") == 0)
+	{
+		if (argc < 3)
+		{
+			printf("prepare: skipped, no database given\n");
+			return 0;
+		}
+		return PrepareBenchmark(argc > 3 ? argv[3] : "localhost", argv[2],
+			argc > 4 ? argv[4] : "SYSDBA", argc > 5 ? argv[5] : "masterkey");
+	}
+
+	printf("Usage: benchmarks columnnum\n"
+		"       benchmarks prepare <database> [<server> <user> <password>]\n");
+	return 2;
+}
+
+//	Eof
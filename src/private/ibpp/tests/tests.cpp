@@ -370,6 +370,7 @@ void Test::Test3()
 							"TS TIMESTAMP, "
 							"B BLOB SUB_TYPE 1, "
 							"BB BLOB SUB_TYPE 0, "
+							"BU BLOB SUB_TYPE TEXT CHARACTER SET UTF8, "
 							"TF CHAR(1), "
 							"ID INTEGER, "
 							"TX CHAR(30), "
@@ -630,6 +631,27 @@ void Test::Test4()
 
 	tr1->CommitRetain();
 
+	// Binding the id of a created blob, the way TsSqlBlobWriter passes it
+	// on, to a text blob whose character set is kept in the scale
+	b1->Create();
+	b1->Write("UTF8 BLOB", 9);
+	b1->Close();
+	IBPP::ValueView id;
+	b1->GetId(id);
+	st1->Prepare("update test set BU = ? where ID = 1");
+	st1->Set(1, id);
+	st1->Execute();
+	st1->Execute("select BU from test where ID = 1");
+	st1->Fetch();
+	std::string bus;
+	st1->Get(1, bus);
+	if (bus != "UTF8 BLOB")
+	{
+		_Success = false;
+		printf(_("Blob id bound to a UTF8 text blob read back as '%s'.\n"), bus.c_str());
+	}
+	tr1->CommitRetain();
+
 	st1->Prepare("select B, BB, A2 from test where ID = 1");
 
 	std::string plan;
@@ -2,6 +2,7 @@
 
 # On typical Linux, use this: (comment / uncomment as required)
 #g++ -O2 -W -Wall -DIBPP_LINUX ../tests.cpp ../../core/all_in_one.cpp -lfbclient -lcrypt -lm -lpthread -o tests
+#g++ -O2 -W -Wall -DIBPP_LINUX ../benchmarks.cpp ../../core/all_in_one.cpp -lfbclient -lcrypt -lm -lpthread -o benchmarks
 
 # On Darwin, use this: (comment / uncomment as required)
 g++ -O2 -W -Wall -DIBPP_DARWIN ../tests.cpp ../../core/all_in_one.cpp -framework Firebird -lm -lpthread -o tests
@@ -2,12 +2,39 @@
 
 TsSqlTableModel::TsSqlTableModel(TsSqlBuffer &buffer):
    m_buffer(buffer),
+   m_updatePending(false),
    m_rowCount(0),
    m_colCount(0)
 {
-   connect(&m_updateTimer, SIGNAL(timeout()), this, SLOT(updateRowCount()));
-   m_updateTimer.start(500);
    connect(&buffer, SIGNAL(columnsChanged()), this, SLOT(updateColumns()));
+   connect(
+      &buffer,
+      SIGNAL(rowsAppended(unsigned, unsigned)),
+      this,
+      SLOT(scheduleUpdate()));
+   connect(&buffer, SIGNAL(rowDeleted(unsigned)), this, SLOT(rowDeleted(unsigned)));
+   connect(&buffer, SIGNAL(cleared()),            this, SLOT(cleared()));
+   scheduleUpdate();
+   connect(
+      &buffer,
+      SIGNAL(rowsResolved(unsigned, unsigned)),
+      this,
+      SLOT(rowsResolved(unsigned, unsigned)));
+}
+
+void TsSqlTableModel::setViewport(int first, int last)
+{
+   if (first >= 0 && last >= first)
+      m_buffer.setViewport(first, last);
+}
+
+void TsSqlTableModel::rowsResolved(unsigned first, unsigned last)
+{
+   // Rows the model doesn't show yet are painted when they are inserted
+   if (int(first) >= m_rowCount || m_colCount == 0)
+      return;
+   last = qMin(last, unsigned(m_rowCount - 1));
+   emit dataChanged(index(first, 0), index(last, m_colCount - 1));
 }
 
 void TsSqlTableModel::updateColumns()
@@ -18,30 +45,63 @@ void TsSqlTableModel::updateColumns()
       m_columnNames[i] = m_buffer.dataStatement()->columnName(i);
    if (colCount > m_colCount)
    {
-      beginInsertColumns(QModelIndex(), m_colCount, m_colCount + colCount - 1);
+      beginInsertColumns(QModelIndex(), m_colCount, colCount - 1);
       m_colCount = colCount;
       endInsertColumns();
    }
    else if (colCount < m_colCount)
    {
-      beginRemoveColumns(QModelIndex(), colCount, m_colCount);
+      beginRemoveColumns(QModelIndex(), colCount, m_colCount - 1);
       m_colCount = colCount;
       endRemoveColumns();
    }
 }
 
+// The rows shown are always the first m_rowCount rows of the buffer, as
+// the buffer's signals are handled in order. Deleting and clearing are
+// reported as they happen, appended rows are collected.
+void TsSqlTableModel::cleared()
+{
+   beginResetModel();
+   m_rowCount = 0;
+   endResetModel();
+   emit rowsUpdated();
+}
+
+// A row the model doesn't show yet is just not counted by the next update
+void TsSqlTableModel::rowDeleted(unsigned index)
+{
+   if (int(index) >= m_rowCount)
+      return;
+   beginRemoveRows(QModelIndex(), index, index);
+   --m_rowCount;
+   endRemoveRows();
+   emit rowsUpdated();
+}
+
+// All rows appended until the event loop gets control again end up in one
+// updateRowCount().
+void TsSqlTableModel::scheduleUpdate()
+{
+   if (m_updatePending)
+      return;
+   m_updatePending = true;
+   QMetaObject::invokeMethod(this, "updateRowCount", Qt::QueuedConnection);
+}
+
 void TsSqlTableModel::updateRowCount()
 {
+   m_updatePending = false;
    int rowCount = m_buffer.count();
    if (rowCount > m_rowCount)
    {
-      beginInsertRows(QModelIndex(), m_rowCount, m_rowCount + rowCount - 1);
+      beginInsertRows(QModelIndex(), m_rowCount, rowCount - 1);
       m_rowCount = rowCount;
       endInsertRows();
    }
    else if (rowCount < m_rowCount)
    {
-      beginRemoveRows(QModelIndex(), rowCount, m_rowCount);
+      beginRemoveRows(QModelIndex(), rowCount, m_rowCount - 1);
       m_rowCount = rowCount;
       endRemoveRows();
    }
@@ -64,9 +124,12 @@ int TsSqlTableModel::columnCount(const QModelIndex &parent) const
 
 QVariant TsSqlTableModel::data(const QModelIndex &index, int role) const
 {
-   if (role == Qt::DisplayRole)
-      return m_buffer.getRow(index.row())[index.column()].asVariant();
-   return QVariant();
+   // The buffer may have been cleared or shrunk before updateRowCount()
+   if (role != Qt::DisplayRole || unsigned(index.row()) >= m_buffer.count())
+      return QVariant();
+   if (m_buffer.prefetchStatement() && !m_buffer.isResolved(index.row()))
+      return tr("...");
+   return m_buffer.cell(index.row(), index.column()).asVariant();
 }
 
 QVariant TsSqlTableModel::headerData(int section, Qt::Orientation orientation, int role) const
@@ -76,6 +139,91 @@ QVariant TsSqlTableModel::headerData(int section, Qt::Orientation orientation, i
    return QVariant();
 }
 
+TsSqlColumnarTableModel::TsSqlColumnarTableModel(const TsSqlColumnarBuffer &buffer):
+   m_buffer(buffer)
+{
+}
+
+void TsSqlColumnarTableModel::update()
+{
+   reset();
+}
+
+int TsSqlColumnarTableModel::rowCount(const QModelIndex &parent) const
+{
+   if (parent != QModelIndex())
+      return 0;
+   return m_buffer.rowCount();
+}
+
+int TsSqlColumnarTableModel::columnCount(const QModelIndex &parent) const
+{
+   if (parent != QModelIndex())
+      return 0;
+   return m_buffer.columnCount();
+}
+
+QVariant TsSqlColumnarTableModel::data(const QModelIndex &index, int role) const
+{
+   if (role == Qt::DisplayRole)
+      return m_buffer.value(index.row(), index.column()).asVariant();
+   return QVariant();
+}
+
+QVariant TsSqlColumnarTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+   if (orientation == Qt::Horizontal && role == Qt::DisplayRole)
+      return m_buffer.columnName(section);
+   return QVariant();
+}
+
 TsSqlTableView::TsSqlTableView(QWidget *parent): QTableView(parent)
 {
 }
+
+void TsSqlTableView::setModel(QAbstractItemModel *model)
+{
+   if (this->model())
+      disconnect(
+         this->model(),
+         SIGNAL(rowsInserted(QModelIndex, int, int)),
+         this,
+         SLOT(updateViewport()));
+   QTableView::setModel(model);
+   // Rows appended to an empty view become visible without scrolling
+   if (model)
+      connect(
+         model,
+         SIGNAL(rowsInserted(QModelIndex, int, int)),
+         this,
+         SLOT(updateViewport()));
+   updateViewport();
+}
+
+void TsSqlTableView::scrollContentsBy(int dx, int dy)
+{
+   QTableView::scrollContentsBy(dx, dy);
+   if (dy != 0)
+      updateViewport();
+}
+
+void TsSqlTableView::resizeEvent(QResizeEvent *event)
+{
+   QTableView::resizeEvent(event);
+   updateViewport();
+}
+
+void TsSqlTableView::updateViewport()
+{
+   TsSqlTableModel *sqlModel = qobject_cast<TsSqlTableModel*>(model());
+   if (!sqlModel)
+      return;
+   int first = rowAt(0);
+   if (first < 0)
+      return;
+   int last = rowAt(viewport()->height() - 1);
+   // The last row ends above the bottom of the viewport
+   if (last < 0)
+      last = sqlModel->rowCount(QModelIndex()) - 1;
+   sqlModel->setViewport(first, last);
+}
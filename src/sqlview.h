@@ -2,21 +2,33 @@
 #define TS_SQL_TREEVIEW_H_28092008
 #include <QAbstractTableModel>
 #include <QTableView>
-#include <QTimer>
+#include <QResizeEvent>
 
 #include "database.h"
 
+// With a prefetch statement set on the buffer, rows which are not resolved
+// yet are shown as placeholders while the buffer resolves them in the
+// background, so data() never waits for the database. The visible rows
+// must be reported by setViewport(), which TsSqlTableView does.
+// Rows appended to the buffer are collected until control returns to the
+// event loop and then reported as one range.
 class TsSqlTableModel: public QAbstractTableModel
 {
    Q_OBJECT
    private:
       TsSqlBuffer     &m_buffer;
-      QTimer           m_updateTimer;
+      bool             m_updatePending;
       int m_rowCount,  m_colCount;
       QVector<QString> m_columnNames;
+   private slots:
+      void rowsResolved(unsigned first, unsigned last);
+      void cleared();
+      void rowDeleted(unsigned index);
+      void scheduleUpdate();
    public slots:
       void updateRowCount();
       void updateColumns();
+      void setViewport(int first, int last);
    public:
       TsSqlTableModel(TsSqlBuffer &buffer);
       virtual int rowCount(   const QModelIndex &parent) const;
@@ -27,10 +39,34 @@ class TsSqlTableModel: public QAbstractTableModel
       void rowsUpdated();
 };
 
+// Shows a TsSqlColumnarBuffer, call update() after filling it.
+class TsSqlColumnarTableModel: public QAbstractTableModel
+{
+   Q_OBJECT
+   private:
+      const TsSqlColumnarBuffer &m_buffer;
+   public slots:
+      void update();
+   public:
+      TsSqlColumnarTableModel(const TsSqlColumnarBuffer &buffer);
+      virtual int rowCount(   const QModelIndex &parent) const;
+      virtual int columnCount(const QModelIndex &parent) const;
+      virtual QVariant data(  const QModelIndex &index, int role) const;
+      QVariant headerData(int section, Qt::Orientation orientation, int role) const;
+};
+
+// Reports the visible rows to a TsSqlTableModel
 class TsSqlTableView: public QTableView
 {
+   Q_OBJECT
+   private slots:
+      void updateViewport();
+   protected:
+      virtual void scrollContentsBy(int dx, int dy);
+      virtual void resizeEvent(QResizeEvent *event);
    public:
       TsSqlTableView(QWidget *parent);
+      virtual void setModel(QAbstractItemModel *model);
 };
 
 #endif